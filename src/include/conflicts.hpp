@@ -9,25 +9,100 @@
 *   \author Christophe COUAILLET
 */
 
-#include <requirements.hpp>
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <functional>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "conflicts_components.hpp"
+#include "conflicts_engines.hpp"
 
 namespace Conflicts
 {
 
+    // snapshots are defined in conflicts_frozen.hpp, that must be included to call Conflicts::freeze()
+    template <typename T, typename Hash, typename KeyEqual>
+    class FrozenConflicts;
+    enum class Ordering;
+    enum class Pages;
+
+    /*! \brief Validation policy that asserts the rules in debug builds and ignores the changes breaking them in release builds.
+    *
+        In cascading mode, a component index is maintained so that an existing conflict is checked in constant time.
+    */
+    struct CheckedValidation
+    {
+        static constexpr bool enabled = true;
+        static bool check(bool valid, [[maybe_unused]] const char* message) noexcept
+        {
+            assert(valid && "Conflicts rule broken, see message.");
+            return valid;
+        }
+    };
+
+    /*! \brief Validation policy that throws std::invalid_argument when a change breaks the rules. */
+    struct ThrowingValidation
+    {
+        static constexpr bool enabled = true;
+        static bool check(bool valid, const char* message)
+        {
+            if (!valid)
+                throw std::invalid_argument(message);
+            return valid;
+        }
+    };
+
+    /*! \brief Validation policy without any check, for bulk loads of relationships known to be valid.
+    *
+        \warning Breaking the rules corrupts the instance. No component index is maintained in cascading mode,
+        conflicts are then evaluated by searching the relationships.
+    */
+    struct TrustedValidation
+    {
+        static constexpr bool enabled = false;
+        static bool check(bool, const char*) noexcept { return true; }
+    };
+
+    /*! \brief Validation policy used when none is specified. */
+    using DefaultValidation = CheckedValidation;
+
     /*! \brief Class conflicts implements a specialized container that lists the bidirectional conflict relationships between objects.
     *
         Create a relationship with an object itself is not allowed.
         Doubles are not allowed, each relationship is unique.
-        The class Conflicts supports two distinct modes at instantiation:
+        The class Conflicts supports three distinct modes at instantiation:
         \li without cascading: only direct relationships between objects are considered.
         \li with cascading: conflicts between objects are evaluated by recursing relationships (if an object A is in conflict with an object B that is in conflict with an object C, then A is in conflict with C).
+        \li with a bounded depth: objects are in conflict when linked by a path of at most the given number of relationships, see Depth.
+
+        \warning The mode is immutable, it cannot be changed after instantiation.
 
-        \warning The cascading mode is immutable, it cannot be changed after instantiation.
+        The relationships are kept in the storage provided by the Engine (see is_storage), DefaultEngine if not specified.
+        Hash and KeyEqual are used by all the hash tables of the instance, see PrecomputedHash for objects that store their hash value.
+        The Validation policy sets how the rules are enforced, see CheckedValidation, ThrowingValidation and TrustedValidation.
     */
-    template <typename T>
+    template <typename T, typename Engine = DefaultEngine, typename Hash = std::hash<T>, typename KeyEqual = std::equal_to<T>,
+        typename Validation = DefaultValidation>
     class Conflicts
     {
     public:
+        using value_type = T;
+        using hasher = Hash;
+        using key_equal = KeyEqual;
+        using storage_type = typename Engine::template storage<T, Hash, KeyEqual>;
+        using pairs_type = std::unordered_multimap<T, T, Hash, KeyEqual>;
+        static_assert(is_storage_v<storage_type, T>, "The engine does not provide a conforming storage.");
+
+        /*! \brief Component label of the objects not involved in any relationship. */
+        static constexpr size_t npos = ComponentIndex<T, Hash, KeyEqual>::npos;
+
         /*! \brief Default constructor. Cascading mode is not activated. */
         Conflicts() : Conflicts(false) {};
 
@@ -35,231 +110,822 @@ namespace Conflicts
         *   \param cascading sets the cascading mode of the instance to create
         */
         Conflicts(const bool cascading)
-            : m_cascading(cascading) {};
+            : m_cascading(cascading), m_depth(cascading ? Depth::unbounded : 1) {};
+
+        /*! \brief Constructor with a depth, conflicts being evaluated by recursing at most the given number of relationships.
+        *   \param depth the maximum number of relationships between objects in conflict, 1 meaning no cascading and Depth::unbounded cascading
+        */
+        Conflicts(const Depth depth)
+            : m_cascading(depth.hops == Depth::unbounded), m_depth(std::max<size_t>(depth.hops, 1)) {};
 
         /*! \brief Informs on the cascading mode of the instance
         *   \return true if cascading mode is activated
         */
-        bool cascading() { return m_cascading; }
+        bool cascading() const noexcept { return m_cascading; }
+
+        /*! \brief Gets the maximum number of relationships between objects in conflict.
+        *   \return 1 without cascading, Depth::unbounded with cascading, the depth given at instantiation otherwise
+        */
+        size_t depth() const noexcept { return m_depth; }
 
         /*! \brief Clears all relationships.*/
-        void clear() noexcept { m_conflicts.clear(); }
+        void clear() noexcept { m_conflicts.clear(); m_components.clear(); }
 
         /*! \brief Checks if any relationship has been set.
         *   \return true if no conflict relationship exists
         */
-        bool empty() const noexcept { return m_conflicts.empty(); }
+        bool empty() const noexcept(noexcept(std::declval<const storage_type&>().empty())) { return relationships().empty(); }
 
         /*! \brief Gets the number of existing relationships in the instance.
         *   \return the number of conflict relationships defined in the instance
         */
-        size_t size() const noexcept { return m_conflicts.size(); }
+        size_t size() const noexcept(noexcept(std::declval<const storage_type&>().size())) { return relationships().size(); }
+
+        /*! \brief Prepares the instance for the given number of objects, avoiding rehashes while they are added.
+        *   \param objects the number of objects expected to be involved in conflict relationships
+        */
+        void reserve(size_t objects) { m_conflicts.reserve(objects); }
+
+        FrozenConflicts<T, Hash, KeyEqual> freeze() const;
+        FrozenConflicts<T, Hash, KeyEqual> freeze(Ordering ordering) const;
+        FrozenConflicts<T, Hash, KeyEqual> freeze(Ordering ordering, Pages pages) const;
 
         void add(const T& object1, const T& object2);
+        void add(const T& object1, const T& object2, Weight weight);
+        template <typename Rep, typename Period>
+        void add(const T& object1, const T& object2, std::chrono::duration<Rep, Period> ttl);
+        void expire();
+        template <typename S = storage_type>
+        void join(const T& object, const typename S::group_type& group);
+        template <typename S = storage_type>
+        void leave(const T& object, const typename S::group_type& group);
+        template <typename S = storage_type>
+        void add_group_conflict(const typename S::group_type& group1, const typename S::group_type& group2);
+        template <typename S = storage_type>
+        void remove_group_conflict(const typename S::group_type& group1, const typename S::group_type& group2);
+        template <typename S = storage_type>
+        void set_interval(const T& object, const typename S::position_type& start, const typename S::position_type& end);
+        void remove_interval(const T& object);
         void remove(const T& object1, const T& object2);
         void remove(const T& object);
         bool in_conflict(const T& object) const noexcept;
         bool in_conflict(const T& object1, const T& object2) const noexcept;
+        bool in_conflict(const T& object1, const T& object2, Weight min_weight) const;
+        Weight weight(const T& object1, const T& object2) const;
         std::vector<T> conflicts(const T& object) const;                            // lists direct conflicts
+        std::vector<T> conflicts(const T& object, Weight min_weight) const;         // lists direct conflicts of a minimum weight
         std::vector<T> all_conflicts(const T& object) const;                        // lists all implicit conflicts if cascading is on
-        std::unordered_multimap<T, T> get() const;
-        void set(const std::unordered_multimap<T, T>& conflicts);
-        void merge(const std::unordered_multimap<T, T>& conflicts);
+        std::vector<T> conflicts_within(const T& object, size_t hops) const;        // lists conflicts up to a number of relationships
+        std::vector<T> common_conflicts(const T& object1, const T& object2) const;  // lists direct conflicts shared by both objects
+        bool shares_conflict(const T& object1, const T& object2) const;
+        double conflict_similarity(const T& object1, const T& object2) const;
+        std::vector<T> compatible_with(const std::vector<T>& set, const std::vector<T>& candidates) const;
+        std::vector<std::pair<T, size_t>> top_conflicted(size_t k) const;
+        std::vector<size_t> largest_components(size_t k) const;
+        ComponentList<T> components() const;
+        size_t component_id(const T& object) const;
+        std::unordered_map<T, size_t, Hash, KeyEqual> component_labels() const;    // labels all the objects in relationship at once
+        pairs_type get() const;
+        void set(const pairs_type& conflicts);
+        void merge(const pairs_type& conflicts);
 
     private:
-        Requirements::Requirements<T> m_conflicts{ false };
+        storage_type m_conflicts{};
         bool m_cascading{ false };
+        size_t m_depth{ 1 };
         // if cascading is on, an object in conflict with another object is in conflict with all objects in relation with this object
+        ComponentIndex<T, Hash, KeyEqual> m_components{};
+
+        // conflicts given by groups or intervals are not relationships: they change without notice to the index and form cycles
+        static constexpr bool implicit = is_implicit_v<storage_type, T>;
+
+        // relationships that expire change without notice to the index too
+        bool indexed() const noexcept { return Validation::enabled && m_cascading && !is_expiring_v<storage_type, T> && !implicit; }
+        // cascading conflicts are searched as within an unbounded depth when they may form cycles
+        bool bounded() const noexcept { return (!m_cascading && m_depth > 1) || (m_cascading && implicit); }
 
-        bool deep_search(const T& object1, const T& object2, const T* prev = NULL) const noexcept;
-        std::vector<T> all_conflicts(const T& object, const T* prev) const;
+        static constexpr Weight any_weight = std::numeric_limits<Weight>::lowest();
+
+        bool admit(const T& object1, const T& object2);
+        // relationships that expire are queried at a single time point per operation
+        decltype(auto) relationships() const
+        {
+            if constexpr (is_expiring_v<storage_type, T>)
+                return m_conflicts.current();
+            else
+                return (m_conflicts);
+        }
+
+        template <typename S, typename F>
+        bool for_each_heavy(const S& storage, const T& object, Weight min_weight, F&& f) const;
+        template <typename S, typename F>
+        bool bounded_search(const S& storage, const T& object, size_t hops, F&& f, Weight min_weight = any_weight) const;
+
+        template <typename S>
+        bool deep_search(const S& storage, const T& object1, const T& object2) const noexcept;
+        template <typename S>
+        std::vector<T> all_conflicts(const S& storage, const T& object, const T* prev) const;
     };
 
     // Implementation of templates functions
 
     /*! \brief Adds a conflict relationship between two objects.
     *   \param object1,object2 objects for which a conflict relationship must be set
-    *   \warning An assertion occurs if the objects are same or if a conflict has already been set for these objects.
-    *   In cascading mode, this existence is evaluated recursively.
+    *   \warning The objects must differ and no conflict must have been set for these objects, as enforced by the Validation policy.
+    *   In cascading mode, this existence is evaluated recursively, and within the depth if bounded.
     */
-    template <typename T>
-    void Conflicts<T>::add(const T& object1, const T& object2)
+    template <typename T, typename Engine, typename Hash, typename KeyEqual, typename Validation>
+    void Conflicts<T, Engine, Hash, KeyEqual, Validation>::add(const T& object1, const T& object2)
     {
-        assert(!(object1 == object2) && "An object can't be in conflict with itself.");
-        // we must ensure the conflict does not already exists, directly or, if cascading is on, indirectly
-        assert(!in_conflict(object1, object2) && "Conflict already exists.");
-        m_conflicts.add(object1, object2);
+        if (admit(object1, object2))
+            m_conflicts.add(object1, object2);
     }
 
-    /*! \brief Removes a direct relationship between two objects.
-    *   \param object1,object2 objects for which the existing conflict relationship must be removed
-    *   \warning An assertion occurs if this conflict relationship does not exist.
+    /*! \brief Adds a weighted conflict relationship between two objects.
+    *   \param object1,object2 objects for which a conflict relationship must be set
+    *   \param weight the weight of the relationship, such as its severity
+    *   \warning The rules are enforced as by add(const T&, const T&), the weight being ignored. The engine must keep weights, see is_weighted.
     */
-    template <typename T>
-    void Conflicts<T>::remove(const T& object1, const T& object2)
+    template <typename T, typename Engine, typename Hash, typename KeyEqual, typename Validation>
+    void Conflicts<T, Engine, Hash, KeyEqual, Validation>::add(const T& object1, const T& object2, Weight weight)
     {
-        // conflict definition is searched for the 2 directions (object, conflict) and (conflict, object)
-        bool found{ false };
-        if (m_conflicts.exists(object1, object2))
-        {
-            m_conflicts.remove(object1, object2);
-            found = true;
-        }
-        if (m_conflicts.exists(object2, object1))
+        static_assert(is_weighted_v<storage_type, T>, "The engine does not keep weights.");
+        if (admit(object1, object2))
+            m_conflicts.add(object1, object2, weight);
+    }
+
+    /*! \brief Adds a conflict relationship between two objects, removed once its time to live is elapsed.
+    *   \param object1,object2 objects for which a conflict relationship must be set
+    *   \param ttl the time to live of the relationship, rounded up to the resolution of the clock of the engine
+    *   \warning The rules are enforced as by add(const T&, const T&). The engine must let relationships expire, see ExpiringEngine.
+    *   The component index is not maintained for such engines, conflicts are then evaluated by searching the relationships in cascading mode.
+    */
+    template <typename T, typename Engine, typename Hash, typename KeyEqual, typename Validation>
+    template <typename Rep, typename Period>
+    void Conflicts<T, Engine, Hash, KeyEqual, Validation>::add(const T& object1, const T& object2, std::chrono::duration<Rep, Period> ttl)
+    {
+        static_assert(is_expiring_v<storage_type, T>, "The engine does not let relationships expire.");
+        if (admit(object1, object2))
+            m_conflicts.add(object1, object2, std::chrono::ceil<typename storage_type::duration>(ttl));
+    }
+
+    /*! \brief Removes the relationships whose time to live is elapsed, releasing their memory.
+    *
+    *   The queries already skip these relationships, and every change removes them too: this is only needed to reclaim the memory
+    *   of an instance that is no longer changed. The engine must let relationships expire, see ExpiringEngine.
+    */
+    template <typename T, typename Engine, typename Hash, typename KeyEqual, typename Validation>
+    void Conflicts<T, Engine, Hash, KeyEqual, Validation>::expire()
+    {
+        static_assert(is_expiring_v<storage_type, T>, "The engine does not let relationships expire.");
+        m_conflicts.expire();
+    }
+
+    // enforces the rules of a new relationship and links the components, returns false if the relationship must not be stored
+    template <typename T, typename Engine, typename Hash, typename KeyEqual, typename Validation>
+    bool Conflicts<T, Engine, Hash, KeyEqual, Validation>::admit(const T& object1, const T& object2)
+    {
+        if constexpr (Validation::enabled)
         {
-            m_conflicts.remove(object2, object1);
-            found = true;
+            if (!Validation::check(!KeyEqual{}(object1, object2), "An object can't be in conflict with itself."))
+                return false;
+            // we must ensure the conflict does not already exists, directly or, if cascading is on, indirectly
+            if (!Validation::check(!in_conflict(object1, object2), "Conflict already exists."))
+                return false;
         }
-        assert(found && "Conflict does not exist.");
+        if (indexed())
+            m_components.link(object1, object2, m_conflicts);
+        return true;
+    }
+
+    /*! \brief Adds an object to a group, setting it in conflict with the members of the groups in conflict with this group.
+    *   \param object the new member
+    *   \param group the group to join
+    *   \warning The object must not belong to the group yet, as enforced by the Validation policy. The engine must support groups,
+    *   see GroupedEngine. The component index is not maintained for such engines, conflicts are then evaluated by searching the relationships
+    *   in cascading mode.
+    */
+    template <typename T, typename Engine, typename Hash, typename KeyEqual, typename Validation>
+    template <typename S>
+    void Conflicts<T, Engine, Hash, KeyEqual, Validation>::join(const T& object, const typename S::group_type& group)
+    {
+        static_assert(is_grouped_v<S, T>, "The engine does not support groups.");
+        Validation::check(m_conflicts.join(object, group), "Object already belongs to the group.");
+    }
+
+    /*! \brief Removes an object from a group, and thus the conflicts given by this group.
+    *   \param object the member to remove
+    *   \param group the group to leave
+    *   \warning The object must belong to the group, as enforced by the Validation policy.
+    */
+    template <typename T, typename Engine, typename Hash, typename KeyEqual, typename Validation>
+    template <typename S>
+    void Conflicts<T, Engine, Hash, KeyEqual, Validation>::leave(const T& object, const typename S::group_type& group)
+    {
+        static_assert(is_grouped_v<S, T>, "The engine does not support groups.");
+        Validation::check(m_conflicts.leave(object, group), "Object does not belong to the group.");
+    }
+
+    /*! \brief Sets each member of a group in conflict with each member of another group, current and future.
+    *   \param group1,group2 the groups in conflict, the same group setting its members in conflict with each other
+    *   \warning The rule must not exist yet, as enforced by the Validation policy. A pair in conflict by several rules or relationships
+    *   is seen once.
+    */
+    template <typename T, typename Engine, typename Hash, typename KeyEqual, typename Validation>
+    template <typename S>
+    void Conflicts<T, Engine, Hash, KeyEqual, Validation>::add_group_conflict(const typename S::group_type& group1, const typename S::group_type& group2)
+    {
+        static_assert(is_grouped_v<S, T>, "The engine does not support groups.");
+        Validation::check(m_conflicts.add_rule(group1, group2), "Group conflict already exists.");
+    }
+
+    /*! \brief Removes the conflict between two groups.
+    *   \param group1,group2 the groups in conflict
+    *   \warning The rule must exist, as enforced by the Validation policy.
+    */
+    template <typename T, typename Engine, typename Hash, typename KeyEqual, typename Validation>
+    template <typename S>
+    void Conflicts<T, Engine, Hash, KeyEqual, Validation>::remove_group_conflict(const typename S::group_type& group1, const typename S::group_type& group2)
+    {
+        static_assert(is_grouped_v<S, T>, "The engine does not support groups.");
+        Validation::check(m_conflicts.remove_rule(group1, group2), "Group conflict does not exist.");
+    }
+
+    /*! \brief Sets the interval of an object, that is in conflict with the objects whose intervals overlap.
+    *   \param object the object, whose former interval is replaced
+    *   \param start,end the bounds of the half-open interval [start, end)
+    *   \warning The interval must not be empty, as enforced by the Validation policy. The engine must support intervals, see IntervalEngine.
+    *   The component index is not maintained for such engines, conflicts are then evaluated by searching the relationships in cascading mode.
+    */
+    template <typename T, typename Engine, typename Hash, typename KeyEqual, typename Validation>
+    template <typename S>
+    void Conflicts<T, Engine, Hash, KeyEqual, Validation>::set_interval(const T& object, const typename S::position_type& start,
+        const typename S::position_type& end)
+    {
+        static_assert(is_interval_v<S, T>, "The engine does not support intervals.");
+        if (Validation::check(start < end, "An interval can't be empty."))
+            m_conflicts.set_interval(object, start, end);
+    }
+
+    /*! \brief Removes the interval of an object, and thus the conflicts given by its interval.
+    *   \param object the object
+    *   \warning The object must have an interval, as enforced by the Validation policy.
+    */
+    template <typename T, typename Engine, typename Hash, typename KeyEqual, typename Validation>
+    void Conflicts<T, Engine, Hash, KeyEqual, Validation>::remove_interval(const T& object)
+    {
+        static_assert(is_interval_v<storage_type, T>, "The engine does not support intervals.");
+        Validation::check(m_conflicts.remove_interval(object), "Object has no interval.");
+    }
+
+    /*! \brief Removes a direct relationship between two objects.
+    *   \param object1,object2 objects for which the existing conflict relationship must be removed
+    *   \warning The conflict relationship must exist, as enforced by the Validation policy. A conflict given by groups or intervals is not
+    *   a relationship, it is removed by leave(), remove_group_conflict() or remove_interval().
+    */
+    template <typename T, typename Engine, typename Hash, typename KeyEqual, typename Validation>
+    void Conflicts<T, Engine, Hash, KeyEqual, Validation>::remove(const T& object1, const T& object2)
+    {
+        bool found = m_conflicts.remove(object1, object2);
+        if (!Validation::check(found, "Conflict does not exist."))
+            return;
+        if (indexed())
+            m_components.unlink(object1, object2, m_conflicts);
     }
 
     /*! \brief Removes all existing conflicts involving the object.
     *   \param object the object for which conflict relationships must be removed
-        \warning An assertion occurs if no conflict exists for this object.
+        \warning A conflict must exist for this object, as enforced by the Validation policy.
     */
-    template <typename T>
-    void Conflicts<T>::remove(const T& object)
+    template <typename T, typename Engine, typename Hash, typename KeyEqual, typename Validation>
+    void Conflicts<T, Engine, Hash, KeyEqual, Validation>::remove(const T& object)
     {
-        assert(in_conflict(object) && "Conflict does not exist.");
-        m_conflicts.remove_all(object);
+        if (!Validation::check(in_conflict(object), "Conflict does not exist."))
+            return;
+        if (indexed())
+        {
+            auto confs = conflicts(object);
+            m_conflicts.remove(object);
+            m_components.unlink(object, confs, m_conflicts);
+        }
+        else
+            m_conflicts.remove(object);
     }
 
     /*! \brief Checks if the given object is involved in any conflict relationship.
     *   \param object the object to check
     *   \return true if at least a conflict relationship exists for this object
     */
-    template <typename T>
-    bool Conflicts<T>::in_conflict(const T& object) const noexcept
+    template <typename T, typename Engine, typename Hash, typename KeyEqual, typename Validation>
+    bool Conflicts<T, Engine, Hash, KeyEqual, Validation>::in_conflict(const T& object) const noexcept
     {
-        return  m_conflicts.has_requirements(object) || m_conflicts.has_dependents(object);
+        auto&& storage = relationships();
+        return storage.contains(object);
     }
 
-    template <typename T>
-    bool Conflicts<T>::deep_search(const T& object1, const T& object2, const T* prev) const noexcept
+    template <typename T, typename Engine, typename Hash, typename KeyEqual, typename Validation>
+    template <typename S>
+    bool Conflicts<T, Engine, Hash, KeyEqual, Validation>::deep_search(const S& storage, const T& object1, const T& object2) const noexcept
     {
-        bool result = m_conflicts.exists(object1, object2) || m_conflicts.exists(object2, object1);
-        if (!result && m_cascading)
+        // Deep search : if 2 objects are in conflict then a third one that is in conflict with one of them is in conflict with the other
+        if (KeyEqual{}(object1, object2))
+            return storage.contains(object1);
+        if (storage.exists(object1, object2))
+            return true;
+        if (!storage.contains(object1) || !storage.contains(object2))
+            return false;
+        // Bidirectional breadth first search: the side whose frontier has the lowest total degree is expanded first,
+        // so that a hub is only expanded when unavoidable. Exhausting either side is conclusive.
+        // Cascading relationships form a forest: skipping its parent is enough to never reach an object twice,
+        // and both searches can only meet on the last level of the other side.
+        struct Side
         {
-            // Deep search : if 2 objects are in conflict then a third one that is in conflict with one of them is in conflict with the other
-            auto requirements = m_conflicts.requirements(object1);
-            auto req = requirements.begin();
-            while (!result && req != requirements.end())
+            std::vector<std::pair<T, T>> frontier;              // last level, objects and their parents
+            std::unordered_set<T, Hash, KeyEqual> index{};      // objects of the last level, only when it is large
+            size_t cost;
+
+            bool reached(const T& object) const
             {
-                if (prev == nullptr || !(*req == *prev || *req == object2))
-                    result = deep_search(*req, object2, &object1);
-                ++req;
+                if (frontier.size() <= 8)
+                    return std::any_of(frontier.begin(), frontier.end(), [&object](const std::pair<T, T>& item) { return KeyEqual{}(item.first, object); });
+                return index.count(object) > 0;
             }
-            if (!result)
+        };
+        Side sides[2]{ { { { object1, object1 } }, {}, storage.degree(object1) }, { { { object2, object2 } }, {}, storage.degree(object2) } };
+        while (true)
+        {
+            Side& side = sides[0].cost <= sides[1].cost ? sides[0] : sides[1];
+            const Side& other = &side == &sides[0] ? sides[1] : sides[0];
+            std::vector<std::pair<T, T>> next{};
+            size_t cost{ 0 };
+            for (auto& [object, parent] : side.frontier)
             {
-                auto dependents = m_conflicts.dependents(object1);
-                auto dep = dependents.begin();
-                while (!result && dep != dependents.end())
-                {
-                    if (prev == nullptr || !(*dep == *prev || *dep == object2))
-                        result = deep_search(*dep, object2, &object1);
-                    ++dep;
-                }
+                bool met = !storage.for_each_conflict(object, [&](const T& con)
+                    {
+                        if (KeyEqual{}(con, parent))
+                            return true;
+                        if (other.reached(con))
+                            return false;
+                        next.emplace_back(con, object);
+                        cost += storage.degree(con);
+                        return true;
+                    });
+                if (met)
+                    return true;
             }
+            if (next.empty())
+                return false;
+            side.frontier.swap(next);
+            side.cost = cost;
+            side.index.clear();
+            if (side.frontier.size() > 8)
+                for (auto& item : side.frontier)
+                    side.index.insert(item.first);
         }
-        return result;
     }
 
     /*! \brief Checks if a conflict has been set between 2 objects.
     *   \param object1,object2 the 2 objects for which the conflict relationship is searched for
     *   \return true if the 2 objects are involved in a conflict relationship
     *
-    *   In cascading mode, this evaluation is performed recursively.
+    *   In cascading mode, this evaluation is performed recursively, or by a lookup in the component index if maintained.
+    *   With a bounded depth, the relationships are searched from the object with the lowest degree. The conflicts given by groups or
+    *   intervals are searched the same way in cascading mode, over all the objects reachable, see is_implicit.
     */
-    template <typename T>
-    bool Conflicts<T>::in_conflict(const T& object1, const T& object2) const noexcept
+    template <typename T, typename Engine, typename Hash, typename KeyEqual, typename Validation>
+    bool Conflicts<T, Engine, Hash, KeyEqual, Validation>::in_conflict(const T& object1, const T& object2) const noexcept
     {
-        bool result = deep_search(object1, object2);
-        if (!result)
-            result = deep_search(object2, object1);
-        return result;
+        auto&& storage = relationships();
+        if (indexed())
+            return m_components.connected(object1, object2);
+        if (bounded())
+        {
+            if (KeyEqual{}(object1, object2))
+                return m_cascading && storage.contains(object1);
+            bool swap = storage.degree(object1) > storage.degree(object2);
+            const T& origin = swap ? object2 : object1;
+            const T& target = swap ? object1 : object2;
+            return !bounded_search(storage, origin, m_depth, [&target](const T& con) { return !KeyEqual{}(con, target); });
+        }
+        if (!m_cascading)
+            return storage.exists(object1, object2);
+        return deep_search(storage, object1, object2);
+    }
+
+    /*! \brief Checks if a conflict has been set between 2 objects, only following the relationships of a minimum weight.
+    *   \param object1,object2 the 2 objects for which the conflict relationship is searched for
+    *   \param min_weight the minimum weight of the relationships
+    *   \return true if the 2 objects are linked by relationships of at least min_weight, as by in_conflict(const T&, const T&) otherwise
+    *
+    *   The component index is not used, as it does not keep the weights. The relationships of the storages without weights
+    *   have DefaultWeight.
+    */
+    template <typename T, typename Engine, typename Hash, typename KeyEqual, typename Validation>
+    bool Conflicts<T, Engine, Hash, KeyEqual, Validation>::in_conflict(const T& object1, const T& object2, Weight min_weight) const
+    {
+        auto&& storage = relationships();
+        if (KeyEqual{}(object1, object2))
+            return m_cascading && !for_each_heavy(storage, object1, min_weight, [](const T&) { return false; });
+        if (!m_cascading && m_depth == 1)
+            return storage.exists(object1, object2) && weight(object1, object2) >= min_weight;
+        bool swap = storage.degree(object1) > storage.degree(object2);
+        const T& origin = swap ? object2 : object1;
+        const T& target = swap ? object1 : object2;
+        return !bounded_search(storage, origin, m_depth, [&target](const T& con) { return !KeyEqual{}(con, target); }, min_weight);
+    }
+
+    /*! \brief Gets the weight of a direct relationship.
+    *   \param object1,object2 the objects of the relationship, that must exist
+    *   \return the weight given at creation, DefaultWeight if none or if the engine does not keep weights
+    */
+    template <typename T, typename Engine, typename Hash, typename KeyEqual, typename Validation>
+    Weight Conflicts<T, Engine, Hash, KeyEqual, Validation>::weight(const T& object1, const T& object2) const
+    {
+        if constexpr (is_weighted_v<storage_type, T>)
+            return m_conflicts.weight(object1, object2);
+        else
+            return DefaultWeight;
     }
 
     /*! \brief Lists the objects in direct conflict relationship with the given object.
     *   \param object the object for which conflict relationship are searched for
     *   \return the list of objects in direct conflict with the given object
-    *   \sa Conflicts< T >::all_conflicts()
+    *   \sa Conflicts< T, Engine, Hash, KeyEqual, Validation >::all_conflicts()
+    */
+    template <typename T, typename Engine, typename Hash, typename KeyEqual, typename Validation>
+    std::vector<T> Conflicts<T, Engine, Hash, KeyEqual, Validation>::conflicts(const T& object) const
+    {
+        auto&& storage = relationships();
+        std::vector<T> result{};
+        storage.for_each_conflict(object, [&result](const T& con) { result.push_back(con); return true; });
+        return result;
+    }
+
+    /*! \brief Lists the objects in direct conflict relationship of a minimum weight with the given object.
+    *   \param object the object for which conflict relationship are searched for
+    *   \param min_weight the minimum weight of the relationships
+    *   \return the list of objects in direct conflict with the given object with at least min_weight
+    *   \sa FrozenConflicts::conflicts(const T&, Weight) for scans that stop at the first lighter relationship
     */
-    template <typename T>
-    std::vector<T> Conflicts<T>::conflicts(const T& object) const
+    template <typename T, typename Engine, typename Hash, typename KeyEqual, typename Validation>
+    std::vector<T> Conflicts<T, Engine, Hash, KeyEqual, Validation>::conflicts(const T& object, Weight min_weight) const
     {
+        auto&& storage = relationships();
         std::vector<T> result{};
-        auto confs = m_conflicts.requirements(object);
-        for (auto con : confs)
-            result.push_back(con);
-        confs = m_conflicts.dependents(object);
-        for (auto con : confs)
-            result.push_back(con);
+        for_each_heavy(storage, object, min_weight, [&result](const T& con) { result.push_back(con); return true; });
         return result;
     }
 
-    template <typename T>
-    std::vector<T> Conflicts<T>::all_conflicts(const T& object, const T* prev) const
+    template <typename T, typename Engine, typename Hash, typename KeyEqual, typename Validation>
+    template <typename S>
+    std::vector<T> Conflicts<T, Engine, Hash, KeyEqual, Validation>::all_conflicts(const S& storage, const T& object, const T* prev) const
     {
         std::vector<T> result{};
-        auto confs = m_conflicts.requirements(object);
-        for (auto con : confs)
+        storage.for_each_conflict(object, [&](const T& con)
+            {
+                if (prev == nullptr || !(con == *prev))
+                {
+                    result.push_back(con);
+                    // perform a recursive search
+                    auto res = all_conflicts(storage, con, &object);
+                    for (auto itr : res)
+                        result.push_back(itr);
+                }
+                return true;
+            });
+        return result;
+    }
+
+    /*! \brief Lists the objects in a direct or indirect conflict relationship with the given object.
+    *   \param object the object for which conflict relationships must be checked
+    *   \return the list of objects involved in a direct or indirect conflict relationship with the given object
+    *
+    *   In cascading mode, the objects are searched recursively. With a bounded depth, they are searched within the depth.
+    *   \sa Conflicts< T, Engine, Hash, KeyEqual, Validation >::conflicts()
+    */
+    template <typename T, typename Engine, typename Hash, typename KeyEqual, typename Validation>
+    std::vector<T> Conflicts<T, Engine, Hash, KeyEqual, Validation>::all_conflicts(const T& object) const
+    {
+        if (bounded())
+            return conflicts_within(object, m_depth);
+        if (!m_cascading)
+            return conflicts(object);
+        return all_conflicts(relationships(), object, nullptr);
+    }
+
+    // calls f for each object in direct relationship of at least min_weight, as for_each_conflict()
+    template <typename T, typename Engine, typename Hash, typename KeyEqual, typename Validation>
+    template <typename S, typename F>
+    bool Conflicts<T, Engine, Hash, KeyEqual, Validation>::for_each_heavy(const S& storage, const T& object, Weight min_weight, F&& f) const
+    {
+        if (min_weight == any_weight)
+            return storage.for_each_conflict(object, std::forward<F>(f));
+        if constexpr (is_weighted_v<storage_type, T>)
+            return storage.for_each_weighted(object, [&f, min_weight](const T& con, Weight weight) { return weight < min_weight || f(con); });
+        else
+            return DefaultWeight < min_weight || storage.for_each_conflict(object, std::forward<F>(f));
+    }
+
+    // Breadth first search of the objects within hops relationships of at least min_weight,
+    // calling f for each one by increasing distance until it returns false.
+    template <typename T, typename Engine, typename Hash, typename KeyEqual, typename Validation>
+    template <typename S, typename F>
+    bool Conflicts<T, Engine, Hash, KeyEqual, Validation>::bounded_search(const S& storage, const T& object, size_t hops, F&& f, Weight min_weight) const
+    {
+        std::unordered_set<T, Hash, KeyEqual> visited{};
+        visited.insert(object);
+        std::vector<T> frontier{ object }, next{};
+        for (size_t hop = 0; hop < hops && !frontier.empty(); ++hop)
         {
-            if (prev == nullptr || !(con == *prev))
+            next.clear();
+            for (auto& current : frontier)
             {
-                result.push_back(con);
-                // perform a recursive search
-                auto res = all_conflicts(con, &object);
-                for (auto itr : res)
-                    result.push_back(itr);
+                bool stopped = !for_each_heavy(storage, current, min_weight, [&](const T& con)
+                    {
+                        if (!visited.insert(con).second)
+                            return true;
+                        next.push_back(con);
+                        return f(con);
+                    });
+                if (stopped)
+                    return false;
             }
+            frontier.swap(next);
         }
-        confs = m_conflicts.dependents(object);
-        for (auto con : confs)
+        return true;
+    }
+
+    /*! \brief Lists the objects linked to the given object by a path of at most hops relationships, whatever the mode of the instance.
+    *   \param object the object whose neighbourhood is searched
+    *   \param hops the maximum number of relationships
+    *   \return the objects by increasing distance, the given one excluded
+    *
+    *   The relationships are searched level by level, each object being visited once.
+    */
+    template <typename T, typename Engine, typename Hash, typename KeyEqual, typename Validation>
+    std::vector<T> Conflicts<T, Engine, Hash, KeyEqual, Validation>::conflicts_within(const T& object, size_t hops) const
+    {
+        auto&& storage = relationships();
+        std::vector<T> result{};
+        bounded_search(storage, object, hops, [&result](const T& con) { result.push_back(con); return true; });
+        return result;
+    }
+
+    /*! \brief Lists the objects in direct conflict relationship with both given objects.
+    *   \param object1,object2 the objects whose direct conflicts are intersected
+    *   \return the list of objects in direct conflict with both objects
+    *
+    *   The conflicts of the object with the lowest degree are probed in the other one. See FrozenConflicts for sorted intersections.
+    */
+    template <typename T, typename Engine, typename Hash, typename KeyEqual, typename Validation>
+    std::vector<T> Conflicts<T, Engine, Hash, KeyEqual, Validation>::common_conflicts(const T& object1, const T& object2) const
+    {
+        auto&& storage = relationships();
+        std::vector<T> result{};
+        bool swap = storage.degree(object1) > storage.degree(object2);
+        const T& small = swap ? object2 : object1;
+        const T& large = swap ? object1 : object2;
+        storage.for_each_conflict(small, [&](const T& con)
+            {
+                if (storage.exists(large, con))
+                    result.push_back(con);
+                return true;
+            });
+        return result;
+    }
+
+    /*! \brief Checks if an object is in direct conflict relationship with both given objects.
+    *   \param object1,object2 the objects whose direct conflicts are intersected
+    *   \return true if the objects have a common direct conflict
+    */
+    template <typename T, typename Engine, typename Hash, typename KeyEqual, typename Validation>
+    bool Conflicts<T, Engine, Hash, KeyEqual, Validation>::shares_conflict(const T& object1, const T& object2) const
+    {
+        auto&& storage = relationships();
+        bool swap = storage.degree(object1) > storage.degree(object2);
+        const T& small = swap ? object2 : object1;
+        const T& large = swap ? object1 : object2;
+        return !storage.for_each_conflict(small, [&](const T& con) { return !storage.exists(large, con); });
+    }
+
+    /*! \brief Computes the Jaccard index of the direct conflicts of 2 objects.
+    *   \param object1,object2 the objects whose conflict profiles are compared
+    *   \return the number of common direct conflicts divided by the number of distinct direct conflicts of both objects,
+    *   0 if any object has no conflict
+    *
+    *   The common conflicts are counted as by common_conflicts(). See FrozenConflicts::similar_pairs() to find all the similar pairs.
+    */
+    template <typename T, typename Engine, typename Hash, typename KeyEqual, typename Validation>
+    double Conflicts<T, Engine, Hash, KeyEqual, Validation>::conflict_similarity(const T& object1, const T& object2) const
+    {
+        auto&& storage = relationships();
+        size_t degree1 = storage.degree(object1), degree2 = storage.degree(object2);
+        if (degree1 == 0 || degree2 == 0)
+            return 0;
+        const T& small = degree1 > degree2 ? object2 : object1;
+        const T& large = degree1 > degree2 ? object1 : object2;
+        size_t common{ 0 };
+        storage.for_each_conflict(small, [&](const T& con) { common += storage.exists(large, con); return true; });
+        return static_cast<double>(common) / static_cast<double>(degree1 + degree2 - common);
+    }
+
+    /*! \brief Lists the candidates that are not in conflict with any member of a set.
+    *   \param set the members
+    *   \param candidates the objects to check
+    *   \return the compatible candidates, in their given order
+    *
+    *   The conflicts of the members are gathered once, each candidate is then checked with a single lookup.
+    *   With the component index, only the labels of the members are gathered. See FrozenConflicts for bitset masks.
+    */
+    template <typename T, typename Engine, typename Hash, typename KeyEqual, typename Validation>
+    std::vector<T> Conflicts<T, Engine, Hash, KeyEqual, Validation>::compatible_with(const std::vector<T>& set, const std::vector<T>& candidates) const
+    {
+        auto&& storage = relationships();
+        std::vector<T> result{};
+        if (indexed())
         {
-            if (prev == nullptr || !(con == *prev))
+            std::unordered_set<size_t> labels;
+            for (auto& object : set)
+                labels.insert(m_components.label(object));
+            labels.erase(m_components.npos);
+            for (auto& object : candidates)
+                if (labels.count(m_components.label(object)) == 0)
+                    result.push_back(object);
+            return result;
+        }
+        std::unordered_set<T, Hash, KeyEqual> excluded;
+        auto exclude = [&excluded](const T& con) { excluded.insert(con); return true; };
+        for (auto& object : set)
+        {
+            if (bounded() && !m_cascading)
+                bounded_search(storage, object, m_depth, exclude);
+            else if (!m_cascading)
+                storage.for_each_conflict(object, exclude);
+            // a member already excluded belongs to a component gathered before
+            else if (storage.contains(object) && excluded.insert(object).second)
             {
-                result.push_back(con);
-                // perform a recursive search
-                auto res = all_conflicts(con, &object);
-                for (auto itr : res)
-                    result.push_back(itr);
+                if (bounded())
+                    bounded_search(storage, object, m_depth, exclude);
+                else
+                    for (auto& con : all_conflicts(storage, object, nullptr))
+                        excluded.insert(con);
             }
         }
+        for (auto& object : candidates)
+            if (excluded.count(object) == 0)
+                result.push_back(object);
         return result;
     }
 
-    /*! \brief Lists the objects in a direct or indirect conflict relationship with the given object.
-    *   \param object the object for which conflict relationships must be checked
-    *   \return the list of objects involved in a direct or indirect conflict relationship with the given object
+    /*! \brief Lists the objects with the most direct conflicts.
+    *   \param k the maximum number of objects to list
+    *   \return the objects and their number of direct conflicts, by decreasing number, objects of equal number being in no particular order
     *
-    *   In cascading mode, the objects are searched recursively.
-    *   \sa Conflicts< T >::conflicts()
+    *   With a RankedEngine the objects are kept ranked as the relationships change, and are listed in O(k).
+    *   Otherwise all the relationships are scanned.
     */
-    template <typename T>
-    std::vector<T> Conflicts<T>::all_conflicts(const T& object) const
+    template <typename T, typename Engine, typename Hash, typename KeyEqual, typename Validation>
+    std::vector<std::pair<T, size_t>> Conflicts<T, Engine, Hash, KeyEqual, Validation>::top_conflicted(size_t k) const
     {
-        if (!m_cascading)
-            return conflicts(object);
-        return all_conflicts(object, nullptr);
+        auto&& storage = relationships();
+        if constexpr (is_ranked_v<storage_type, T>)
+            return storage.top(k);
+        else
+        {
+            std::unordered_map<T, size_t, Hash, KeyEqual> degrees{};
+            storage.for_each_pair([&degrees](const T& object1, const T& object2) { ++degrees[object1]; ++degrees[object2]; return true; });
+            std::vector<std::pair<T, size_t>> result(degrees.begin(), degrees.end());
+            k = std::min(k, result.size());
+            std::partial_sort(result.begin(), result.begin() + k, result.end(),
+                [](const std::pair<T, size_t>& item1, const std::pair<T, size_t>& item2) { return item1.second > item2.second; });
+            result.resize(k);
+            return result;
+        }
+    }
+
+    /*! \brief Lists the sizes of the largest connected components of the relationships.
+    *   \param k the maximum number of components to list
+    *   \return the numbers of objects of the components, by decreasing number
+    *
+    *   With the component index, the sizes are kept ranked as the relationships change, and are listed in O(k).
+    *   Otherwise the components are walked.
+    */
+    template <typename T, typename Engine, typename Hash, typename KeyEqual, typename Validation>
+    std::vector<size_t> Conflicts<T, Engine, Hash, KeyEqual, Validation>::largest_components(size_t k) const
+    {
+        auto&& storage = relationships();
+        if (indexed())
+            return m_components.largest(k);
+        std::vector<size_t> result{};
+        std::unordered_set<T, Hash, KeyEqual> visited{};
+        std::vector<T> stack{};
+        auto walk = [&](const T& root)
+            {
+                if (!visited.insert(root).second)
+                    return;
+                size_t size{ 0 };
+                stack.push_back(root);
+                while (!stack.empty())
+                {
+                    T current = stack.back();
+                    stack.pop_back();
+                    ++size;
+                    storage.for_each_conflict(current, [&](const T& con)
+                        {
+                            if (visited.insert(con).second)
+                                stack.push_back(con);
+                            return true;
+                        });
+                }
+                result.push_back(size);
+            };
+        storage.for_each_pair([&walk](const T& object1, const T&) { walk(object1); return true; });
+        k = std::min(k, result.size());
+        std::partial_sort(result.begin(), result.begin() + k, result.end(), std::greater<size_t>());
+        result.resize(k);
+        return result;
+    }
+
+    /*! \brief Lists the connected components of the relationships, all the members of a component being in conflict with each other in cascading mode.
+    *   \return the members of each component and its label, as given by component_id()
+    *
+    *   With the component index, the maintained labels are grouped. Otherwise the components are labelled by a single union-find pass
+    *   over the relationships, see find_components().
+    */
+    template <typename T, typename Engine, typename Hash, typename KeyEqual, typename Validation>
+    ComponentList<T> Conflicts<T, Engine, Hash, KeyEqual, Validation>::components() const
+    {
+        auto&& storage = relationships();
+        if (indexed())
+            return m_components.list();
+        std::unordered_map<T, size_t, Hash, KeyEqual> labels{};
+        return find_components<T>(storage, labels);
+    }
+
+    /*! \brief Gets the label of the connected component of an object.
+    *   \param object the object to look for
+    *   \return the label, npos if the object is not involved in any relationship
+    *
+    *   With the component index, the label is read in constant time and is kept until the component is merged or split,
+    *   the largest part keeping it. Otherwise each call runs a union-find pass over all the relationships in O(relationships), the
+    *   label being the position of the component in components() until the next change; use component_labels() to label many objects.
+    */
+    template <typename T, typename Engine, typename Hash, typename KeyEqual, typename Validation>
+    size_t Conflicts<T, Engine, Hash, KeyEqual, Validation>::component_id(const T& object) const
+    {
+        auto&& storage = relationships();
+        if (indexed())
+            return m_components.label(object);
+        if (!storage.contains(object))
+            return npos;
+        std::unordered_map<T, size_t, Hash, KeyEqual> labels{};
+        find_components<T>(storage, labels);
+        return labels.at(object);
+    }
+
+    /*! \brief Gets the label of the connected component of every object involved in a relationship.
+    *   \return the labels, as given by component_id()
+    *
+    *   The labels are computed once, with a single union-find pass over the relationships without the component index.
+    */
+    template <typename T, typename Engine, typename Hash, typename KeyEqual, typename Validation>
+    std::unordered_map<T, size_t, Hash, KeyEqual> Conflicts<T, Engine, Hash, KeyEqual, Validation>::component_labels() const
+    {
+        auto&& storage = relationships();
+        std::unordered_map<T, size_t, Hash, KeyEqual> labels{};
+        if (!indexed())
+        {
+            find_components<T>(storage, labels);
+            return labels;
+        }
+        auto list = m_components.list();
+        labels.reserve(list.members.size());
+        for (size_t i = 0; i < list.size(); ++i)
+            for (size_t pos = list.offsets[i]; pos < list.offsets[i + 1]; ++pos)
+                labels.emplace(std::move(list.members[pos]), list.labels[i]);
+        return labels;
     }
 
     /*! \brief Lists the conflict pairs.
     *   \return the list of object pairs that are in a direct conflict relationship
     */
-    template <typename T>
-    std::unordered_multimap<T, T> Conflicts<T>::get() const
+    template <typename T, typename Engine, typename Hash, typename KeyEqual, typename Validation>
+    typename Conflicts<T, Engine, Hash, KeyEqual, Validation>::pairs_type Conflicts<T, Engine, Hash, KeyEqual, Validation>::get() const
     {
-        return m_conflicts.get();
+        auto&& storage = relationships();
+        pairs_type result{};
+        storage.for_each_pair([&result](const T& object1, const T& object2) { result.emplace(object1, object2); return true; });
+        return result;
     }
 
     /*! \brief Creates the conflicts from the given list. Existing conflicts are cleared first.
     *   \param conflicts the list of object's pairs for which conflict relationships must be created
-    *   \warning An assertion occurs if rules are broken.
-    *   \sa Conflicts< T >::add()
-    *   \sa Conflicts< T >::merge()
+    *   \warning The rules are enforced as by add().
+    *   \sa Conflicts< T, Engine, Hash, KeyEqual, Validation >::add()
+    *   \sa Conflicts< T, Engine, Hash, KeyEqual, Validation >::merge()
     */
-    template <typename T>
-    void Conflicts<T>::set(const std::unordered_multimap<T, T>& conflicts)
+    template <typename T, typename Engine, typename Hash, typename KeyEqual, typename Validation>
+    void Conflicts<T, Engine, Hash, KeyEqual, Validation>::set(const pairs_type& conflicts)
     {
         clear();
         merge(conflicts);
@@ -267,12 +933,12 @@ namespace Conflicts
 
     /*! \brief Adds conflicts from the given list.
     *   \param conflicts the list of object's pairs for which conflict relationships must be added
-    *   \warning An assertion occurs if rules are broken.
-    *   \sa Conflicts< T >::add()
-    *   \sa Conflicts< T >::set()
+    *   \warning The rules are enforced as by add().
+    *   \sa Conflicts< T, Engine, Hash, KeyEqual, Validation >::add()
+    *   \sa Conflicts< T, Engine, Hash, KeyEqual, Validation >::set()
     */
-    template <typename T>
-    void Conflicts<T>::merge(const std::unordered_multimap<T, T>& conflicts)
+    template <typename T, typename Engine, typename Hash, typename KeyEqual, typename Validation>
+    void Conflicts<T, Engine, Hash, KeyEqual, Validation>::merge(const pairs_type& conflicts)
     {
         auto itr = conflicts.begin();
         while (itr != conflicts.end())
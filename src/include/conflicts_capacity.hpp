@@ -0,0 +1,183 @@
+#pragma once
+
+/*! \file conflicts_capacity.hpp
+*	\brief Implements the template class CapacityConstraints, that limits the number of members of a set used together.
+*   \author Christophe COUAILLET
+*/
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <functional>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace Conflicts
+{
+
+    /*! \brief Class CapacityConstraints holds constraints "at most limit of these members may be used together", with a live counter each.
+    *
+        Binary conflicts cannot express such rules without listing all their combinations. A constraint is stored once, with its members,
+        and each object keeps the list of the constraints it belongs to. A selection or a scheduler calls acquire() and release() as it
+        uses and stops using objects, which updates the counters of their constraints in constant time each, so that admissible()
+        only checks the constraints of the object. An object used several times counts as many times.
+        \warning The instance is not thread safe, its users must synchronize the changes of the counters.
+    */
+    template <typename T, typename Hash = std::hash<T>, typename KeyEqual = std::equal_to<T>>
+    class CapacityConstraints
+    {
+    public:
+        /*! \brief Identifier of a constraint. */
+        using id_type = size_t;
+
+        /*! \brief Removes all the constraints. */
+        void clear() noexcept { m_constraints.clear(); m_free.clear(); m_touching.clear(); }
+
+        /*! \brief Checks if no constraint is set. */
+        bool empty() const noexcept { return size() == 0; }
+
+        /*! \brief Gets the number of constraints. */
+        size_t size() const noexcept { return m_constraints.size() - m_free.size(); }
+
+        /*! \brief Adds a constraint.
+        *   \param members the objects of the constraint, doubles being ignored
+        *   \param limit the maximum number of members used together, 0 forbidding any of them
+        *   \return the identifier of the constraint, that may be given again once the constraint is removed
+        */
+        id_type add(const std::vector<T>& members, size_t limit)
+        {
+            id_type id;
+            if (m_free.empty())
+            {
+                id = m_constraints.size();
+                m_constraints.emplace_back();
+            }
+            else
+            {
+                id = m_free.back();
+                m_free.pop_back();
+            }
+            Constraint& constraint = m_constraints[id];
+            constraint.limit = limit;
+            constraint.count = 0;
+            constraint.active = true;
+            std::unordered_set<T, Hash, KeyEqual> distinct{};
+            for (auto& member : members)
+                if (distinct.insert(member).second)
+                {
+                    constraint.members.push_back(member);
+                    m_touching[member].push_back(id);
+                }
+            return id;
+        }
+
+        /*! \brief Removes a constraint, whatever its counter.
+        *   \param id the identifier of the constraint, that must exist
+        */
+        void remove(id_type id)
+        {
+            assert(contains(id) && "Constraint does not exist.");
+            Constraint& constraint = m_constraints[id];
+            for (auto& member : constraint.members)
+            {
+                auto itr = m_touching.find(member);
+                auto& ids = itr->second;
+                ids.erase(std::find(ids.begin(), ids.end(), id));
+                if (ids.empty())
+                    m_touching.erase(itr);
+            }
+            constraint.members.clear();
+            constraint.active = false;
+            m_free.push_back(id);
+        }
+
+        /*! \brief Checks if a constraint exists. */
+        bool contains(id_type id) const noexcept { return id < m_constraints.size() && m_constraints[id].active; }
+
+        /*! \brief Gets the members of a constraint. */
+        const std::vector<T>& members(id_type id) const { return m_constraints.at(id).members; }
+
+        /*! \brief Gets the maximum number of members of a constraint used together. */
+        size_t limit(id_type id) const { return m_constraints.at(id).limit; }
+
+        /*! \brief Gets the number of members of a constraint in use. */
+        size_t count(id_type id) const { return m_constraints.at(id).count; }
+
+        /*! \brief Lists the constraints an object belongs to. */
+        std::vector<id_type> constraints(const T& object) const
+        {
+            auto itr = m_touching.find(object);
+            return itr == m_touching.end() ? std::vector<id_type>{} : itr->second;
+        }
+
+        /*! \brief Checks if an object may be used, no constraint it belongs to having reached its limit.
+        *   \param object the object to check
+        *   \return true if all the constraints of the object have room left, in O(number of constraints of the object)
+        */
+        bool admissible(const T& object) const
+        {
+            auto itr = m_touching.find(object);
+            if (itr != m_touching.end())
+                for (id_type id : itr->second)
+                    if (m_constraints[id].count >= m_constraints[id].limit)
+                        return false;
+            return true;
+        }
+
+        /*! \brief Records the use of an object, incrementing the counters of its constraints.
+        *   \warning The object should be admissible, a counter above its limit making all the members of its constraint inadmissible.
+        */
+        void acquire(const T& object) { adjust(object, true); }
+
+        /*! \brief Uses an object if it is admissible.
+        *   \return true if the object was admissible and is now in use
+        */
+        bool try_acquire(const T& object)
+        {
+            if (!admissible(object))
+                return false;
+            adjust(object, true);
+            return true;
+        }
+
+        /*! \brief Records the end of the use of an object, decrementing the counters of its constraints.
+        *   \warning The object must be in use, and its constraints must not have been changed since it was acquired.
+        */
+        void release(const T& object) { adjust(object, false); }
+
+        /*! \brief Sets all the counters to 0. */
+        void reset() noexcept
+        {
+            for (auto& constraint : m_constraints)
+                constraint.count = 0;
+        }
+
+    private:
+        struct Constraint
+        {
+            std::vector<T> members{};
+            size_t limit{ 0 };
+            size_t count{ 0 };          // members in use
+            bool active{ false };       // unset once removed, until the identifier is given again
+        };
+
+        std::vector<Constraint> m_constraints{};
+        std::vector<id_type> m_free{};                                                  // identifiers of the removed constraints
+        std::unordered_map<T, std::vector<id_type>, Hash, KeyEqual> m_touching{};      // constraints of each object
+
+        void adjust(const T& object, bool increment)
+        {
+            auto itr = m_touching.find(object);
+            if (itr == m_touching.end())
+                return;
+            for (id_type id : itr->second)
+            {
+                size_t& count = m_constraints[id].count;
+                assert((increment || count > 0) && "Object is not in use.");
+                count = increment ? count + 1 : count - 1;
+            }
+        }
+    };
+
+}
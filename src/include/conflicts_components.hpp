@@ -0,0 +1,334 @@
+#pragma once
+
+/*! \file conflicts_components.hpp
+*	\brief Implements the template class ComponentIndex used by Conflicts in cascading mode, and the listing of the components.
+*   \author Christophe COUAILLET
+*/
+
+#include <cassert>
+#include <cstddef>
+#include <functional>
+#include <numeric>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "conflicts_ranking.hpp"
+
+namespace Conflicts
+{
+
+    /*! \brief Connected components of the conflict relationships, their members being stored contiguously.
+    *
+        The members of the component at position i are members[offsets[i]] to members[offsets[i + 1] - 1], and its label is labels[i].
+    */
+    template <typename T>
+    struct ComponentList
+    {
+        std::vector<size_t> offsets{ 0 };
+        std::vector<T> members{};
+        std::vector<size_t> labels{};
+
+        /*! \brief Gets the number of components. */
+        size_t size() const noexcept { return labels.size(); }
+    };
+
+    /*! \brief Labels the connected components of the relationships of a storage with a single union-find pass.
+    *   \param storage the storage of the relationships
+    *   \param labels receives the label of each object involved in a relationship
+    *   \return the components, labelled by their position
+    */
+    template <typename T, typename Hash, typename KeyEqual, typename Storage>
+    ComponentList<T> find_components(const Storage& storage, std::unordered_map<T, size_t, Hash, KeyEqual>& labels)
+    {
+        // objects are interned to positions, the parent of each position being kept in a forest of union by size
+        std::vector<T> objects{};
+        std::vector<size_t> parents{}, sizes{};
+        labels.clear();
+        auto intern = [&](const T& object)
+            {
+                auto [itr, inserted] = labels.emplace(object, objects.size());
+                if (inserted)
+                {
+                    objects.push_back(object);
+                    parents.push_back(itr->second);
+                    sizes.push_back(1);
+                }
+                return itr->second;
+            };
+        auto root = [&parents](size_t pos)
+            {
+                while (parents[pos] != pos)
+                    pos = parents[pos] = parents[parents[pos]];
+                return pos;
+            };
+        storage.for_each_pair([&](const T& object1, const T& object2)
+            {
+                size_t root1 = root(intern(object1)), root2 = root(intern(object2));
+                if (root1 != root2)
+                {
+                    if (sizes[root1] < sizes[root2])
+                        std::swap(root1, root2);
+                    parents[root2] = root1;
+                    sizes[root1] += sizes[root2];
+                }
+                return true;
+            });
+        // components are numbered in the order of their first object, their members are placed by counting sort
+        constexpr size_t none = static_cast<size_t>(-1);
+        ComponentList<T> result{};
+        std::vector<size_t> positions(objects.size(), none);
+        for (size_t pos = 0; pos < objects.size(); ++pos)
+        {
+            size_t top = root(pos);
+            if (positions[top] == none)
+            {
+                positions[top] = result.labels.size();
+                result.labels.push_back(result.labels.size());
+                result.offsets.push_back(sizes[top]);
+            }
+        }
+        std::partial_sum(result.offsets.begin(), result.offsets.end(), result.offsets.begin());
+        std::vector<size_t> fill(result.offsets.begin(), result.offsets.end() - 1), order(objects.size());
+        for (size_t pos = 0; pos < objects.size(); ++pos)
+        {
+            size_t label = positions[root(pos)];
+            order[fill[label]++] = pos;
+            labels[objects[pos]] = label;
+        }
+        result.members.reserve(objects.size());
+        for (size_t pos : order)
+            result.members.push_back(std::move(objects[pos]));
+        return result;
+    }
+
+    /*! \brief Class ComponentIndex maintains a label per connected component of the conflict relationships.
+    *
+        In cascading mode all the objects of a component are in conflict with each other, so that an existing conflict is checked with two lookups.
+        Only objects involved in a relationship are labelled. As cascading relationships never close a cycle, they form a forest:
+        removing a relationship always splits a component, and only the smallest resulting part is relabelled.
+        The sizes of the components are kept in a Ranking, so that the largest ones are listed in O(k).
+    */
+    template <typename T, typename Hash = std::hash<T>, typename KeyEqual = std::equal_to<T>>
+    class ComponentIndex
+    {
+    public:
+        /*! \brief Clears all labels. */
+        void clear() noexcept { m_labels.clear(); m_sizes.clear(); }
+
+        /*! \brief Gets the number of components. */
+        size_t count() const noexcept { return m_sizes.size(); }
+
+        /*! \brief Lists the sizes of the largest components, by decreasing size. */
+        std::vector<size_t> largest(size_t k) const
+        {
+            std::vector<size_t> result{};
+            for (auto& item : m_sizes.top(k))
+                result.push_back(item.second);
+            return result;
+        }
+
+        /*! \brief Label of the objects not involved in any relationship. */
+        static constexpr size_t npos = static_cast<size_t>(-1);
+
+        /*! \brief Lists the components with their labels, in no particular order. */
+        ComponentList<T> list() const
+        {
+            ComponentList<T> result{};
+            std::unordered_map<size_t, size_t> positions{};
+            positions.reserve(m_sizes.size());
+            for (auto& item : m_labels)
+            {
+                auto [itr, inserted] = positions.emplace(item.second, result.labels.size());
+                if (inserted)
+                {
+                    result.labels.push_back(item.second);
+                    result.offsets.push_back(m_sizes.count(item.second));
+                }
+            }
+            std::partial_sum(result.offsets.begin(), result.offsets.end(), result.offsets.begin());
+            std::vector<size_t> fill(result.offsets.begin(), result.offsets.end() - 1);
+            std::vector<const T*> order(m_labels.size());
+            for (auto& item : m_labels)
+                order[fill[positions[item.second]]++] = &item.first;
+            result.members.reserve(order.size());
+            for (auto object : order)
+                result.members.push_back(*object);
+            return result;
+        }
+
+        /*! \brief Gets the label of the component of an object.
+        *   \return the label, npos if the object is not involved in any relationship
+        */
+        size_t label(const T& object) const noexcept
+        {
+            auto itr = m_labels.find(object);
+            return itr == m_labels.end() ? npos : itr->second;
+        }
+
+        /*! \brief Checks if two objects belong to the same component.
+        *   \return true if both objects are labelled the same, an object involved in any relationship being connected to itself
+        */
+        bool connected(const T& object1, const T& object2) const noexcept
+        {
+            auto itr1 = m_labels.find(object1);
+            if (itr1 == m_labels.end())
+                return false;
+            auto itr2 = m_labels.find(object2);
+            return itr2 != m_labels.end() && itr1->second == itr2->second;
+        }
+
+        /*! \brief Merges the components of two objects. Must be called before the relationship is added to the storage.
+        *   \param object1,object2 the objects of the new relationship, not connected yet
+        *   \param storage the storage of the relationships, used to walk the smallest component to relabel
+        */
+        template <typename Storage>
+        void link(const T& object1, const T& object2, const Storage& storage)
+        {
+            auto itr1 = m_labels.find(object1);
+            auto itr2 = m_labels.find(object2);
+            if (itr1 == m_labels.end() && itr2 == m_labels.end())
+            {
+                size_t label = m_next++;
+                m_labels.emplace(object1, label);
+                m_labels.emplace(object2, label);
+                m_sizes.adjust(label, 2);
+            }
+            else if (itr2 == m_labels.end())
+                join(object2, itr1->second);
+            else if (itr1 == m_labels.end())
+                join(object1, itr2->second);
+            else
+            {
+                assert(itr1->second != itr2->second && "Objects are already connected.");
+                // the smallest component takes the label of the largest one
+                size_t label1 = itr1->second, label2 = itr2->second;
+                if (m_sizes.count(label1) < m_sizes.count(label2))
+                    relabel(collect(object1, storage), label1, label2);
+                else
+                    relabel(collect(object2, storage), label2, label1);
+            }
+        }
+
+        /*! \brief Splits a component after a relationship has been removed from the storage.
+        *   \param object1,object2 the objects of the removed relationship
+        *   \param storage the storage of the relationships, already updated
+        */
+        template <typename Storage>
+        void unlink(const T& object1, const T& object2, const Storage& storage)
+        {
+            split({ object1, object2 }, storage);
+        }
+
+        /*! \brief Splits a component after all the relationships of an object have been removed from the storage.
+        *   \param object the object that is no more involved in any relationship
+        *   \param conflicts the objects that were in direct relationship with the removed one
+        *   \param storage the storage of the relationships, already updated
+        */
+        template <typename Storage>
+        void unlink(const T& object, const std::vector<T>& conflicts, const Storage& storage)
+        {
+            std::vector<T> roots{ conflicts };
+            roots.push_back(object);
+            split(roots, storage);
+        }
+
+    private:
+        std::unordered_map<T, size_t, Hash, KeyEqual> m_labels{};
+        Ranking<size_t> m_sizes{};                                      // number of objects per label
+        size_t m_next{ 0 };
+
+        void join(const T& object, size_t label)
+        {
+            m_labels.emplace(object, label);
+            m_sizes.adjust(label, 1);
+        }
+
+        // Walk of a tree: the objects found so far and the stack of the ones to expand, as positions of an object and of its parent.
+        struct Walk
+        {
+            std::vector<T> members;
+            std::vector<std::pair<size_t, size_t>> stack;
+
+            explicit Walk(const T& root) : members{ root }, stack{ { 0, npos } } {}
+
+            // expands one object, returns false once the whole tree has been walked
+            template <typename Storage>
+            bool step(const Storage& storage)
+            {
+                auto [pos, parent] = stack.back();
+                stack.pop_back();
+                T current = members[pos];      // members may grow while the storage iterates
+                storage.for_each_conflict(current, [&](const T& con)
+                    {
+                        // relationships form a forest, skipping the parent is enough to avoid walking back
+                        if (parent == npos || !KeyEqual{}(con, members[parent]))
+                        {
+                            members.push_back(con);
+                            stack.emplace_back(members.size() - 1, pos);
+                        }
+                        return true;
+                    });
+                return !stack.empty();
+            }
+        };
+
+        // lists the objects of the tree holding object
+        template <typename Storage>
+        std::vector<T> collect(const T& object, const Storage& storage) const
+        {
+            Walk walk{ object };
+            while (walk.step(storage));
+            return std::move(walk.members);
+        }
+
+        void relabel(const std::vector<T>& objects, size_t from, size_t to)
+        {
+            for (auto& object : objects)
+                m_labels[object] = to;
+            m_sizes.adjust(to, static_cast<std::ptrdiff_t>(objects.size()));
+            m_sizes.adjust(from, -static_cast<std::ptrdiff_t>(objects.size()));
+        }
+
+        // Walks the trees of the roots in turn, one object at a time, until a single walk remains unfinished.
+        // The finished trees are the smallest ones and get new labels, the remaining one keeps the former label.
+        template <typename Storage>
+        void split(const std::vector<T>& roots, const Storage& storage)
+        {
+            auto itr = m_labels.find(roots.front());
+            if (itr == m_labels.end())
+                return;
+            size_t label = itr->second;
+            std::vector<Walk> walks;
+            walks.reserve(roots.size());
+            for (auto& root : roots)
+                walks.emplace_back(root);
+            size_t pending = walks.size();
+            while (pending > 1)
+            {
+                for (auto& walk : walks)
+                {
+                    if (!walk.stack.empty() && !walk.step(storage) && --pending == 1)
+                        break;
+                }
+            }
+            for (auto& walk : walks)
+            {
+                // the remaining walk may not have started yet, its root is then checked for isolation
+                if (!walk.stack.empty() && storage.contains(walk.members.front()))
+                    continue;
+                if (walk.members.size() == 1)
+                {
+                    // an isolated object is no more part of any component
+                    m_labels.erase(walk.members.front());
+                    m_sizes.adjust(label, -1);
+                }
+                else
+                {
+                    relabel(walk.members, label, m_next++);
+                }
+            }
+        }
+    };
+
+}
@@ -0,0 +1,1413 @@
+#pragma once
+
+/*! \file conflicts_engines.hpp
+*	\brief Implements the storage engines available to the template class Conflicts.
+*   \author Christophe COUAILLET
+*/
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include <requirements.hpp>
+
+#include "conflicts_filter.hpp"
+#include "conflicts_intervals.hpp"
+#include "conflicts_ranking.hpp"
+#include "conflicts_wheel.hpp"
+
+namespace Conflicts
+{
+
+    /*! \brief Storage engine selector. Each engine provides a nested template storage< T, Hash, KeyEqual > implementing the storage interface.
+    *
+        A storage holds the undirected conflict relationships of an instance of Conflicts and must provide:
+        \li void clear(), bool empty() const and size_t size() const, the size being the number of relationships;
+        \li void reserve(size_t) that prepares the storage for the given number of objects;
+        \li void add(const T&, const T&), called only for a new relationship between distinct objects;
+        \li bool remove(const T&, const T&) that returns false if the relationship did not exist;
+        \li void remove(const T&) that removes all the relationships of an object;
+        \li bool exists(const T&, const T&) const that checks a direct relationship in any direction;
+        \li bool contains(const T&) const that checks if an object is involved in any relationship;
+        \li size_t degree(const T&) const that gives the number of direct relationships of an object;
+        \li bool for_each_conflict(const T&, F) const that calls F for each object in direct relationship with the given one,
+        and bool for_each_pair(F) const that calls F for each relationship. Iteration stops as soon as F returns false,
+        and the function then returns false.
+
+        The conformity of a storage is checked at compile time with is_storage. A storage may also keep a weight per relationship,
+        see is_weighted.
+    */
+    template <typename Storage, typename T, typename = void>
+    struct is_storage : std::false_type {};
+
+    template <typename Storage, typename T>
+    struct is_storage<Storage, T, std::void_t<
+        decltype(std::declval<Storage&>().clear()),
+        decltype(std::declval<Storage&>().reserve(size_t{})),
+        decltype(static_cast<bool>(std::declval<const Storage&>().empty())),
+        decltype(static_cast<size_t>(std::declval<const Storage&>().size())),
+        decltype(std::declval<Storage&>().add(std::declval<const T&>(), std::declval<const T&>())),
+        decltype(static_cast<bool>(std::declval<Storage&>().remove(std::declval<const T&>(), std::declval<const T&>()))),
+        decltype(std::declval<Storage&>().remove(std::declval<const T&>())),
+        decltype(static_cast<bool>(std::declval<const Storage&>().exists(std::declval<const T&>(), std::declval<const T&>()))),
+        decltype(static_cast<bool>(std::declval<const Storage&>().contains(std::declval<const T&>()))),
+        decltype(static_cast<size_t>(std::declval<const Storage&>().degree(std::declval<const T&>()))),
+        decltype(static_cast<bool>(std::declval<const Storage&>().for_each_conflict(std::declval<const T&>(), std::declval<bool(*)(const T&)>()))),
+        decltype(static_cast<bool>(std::declval<const Storage&>().for_each_pair(std::declval<bool(*)(const T&, const T&)>())))
+    >> : std::true_type {};
+
+    template <typename Storage, typename T>
+    inline constexpr bool is_storage_v = is_storage<Storage, T>::value;
+
+    /*! \brief Weight of a relationship, such as its severity. */
+    using Weight = double;
+
+    /*! \brief Weight of the relationships added without any, and of all the relationships of the storages that do not keep weights. */
+    inline constexpr Weight DefaultWeight = 1.0;
+
+    /*! \brief Maximum number of relationships linking two objects in conflict.
+    *
+        A depth of 1 only considers direct relationships, an unbounded one is the cascading mode.
+        In between, objects are in conflict when a path of at most hops relationships links them.
+    */
+    struct Depth
+    {
+        size_t hops;
+
+        static constexpr size_t unbounded = std::numeric_limits<size_t>::max();
+    };
+
+    /*! \brief Checks if a storage keeps a weight per relationship, providing:
+    *
+        \li void add(const T&, const T&, Weight) that creates a relationship with its weight;
+        \li Weight weight(const T&, const T&) const that gives the weight of an existing relationship;
+        \li bool for_each_weighted(const T&, F) const that calls F with each object in direct relationship and the weight of the relationship,
+        as for_each_conflict().
+    */
+    template <typename Storage, typename T, typename = void>
+    struct is_weighted : std::false_type {};
+
+    template <typename Storage, typename T>
+    struct is_weighted<Storage, T, std::void_t<
+        decltype(std::declval<Storage&>().add(std::declval<const T&>(), std::declval<const T&>(), Weight{})),
+        decltype(static_cast<Weight>(std::declval<const Storage&>().weight(std::declval<const T&>(), std::declval<const T&>()))),
+        decltype(static_cast<bool>(std::declval<const Storage&>().for_each_weighted(std::declval<const T&>(), std::declval<bool(*)(const T&, Weight)>())))
+    >> : std::true_type {};
+
+    template <typename Storage, typename T>
+    inline constexpr bool is_weighted_v = is_weighted<Storage, T>::value;
+
+    template <typename Storage, typename T, typename = void>
+    struct is_grouped;
+
+    template <typename Storage, typename T, typename = void>
+    struct is_interval;
+
+    /*! \brief Checks if a storage gives conflicts that are not held as relationships, between the members of groups or the objects whose
+    *   intervals overlap, see is_grouped and is_interval. The decorators of such a storage do not see these conflicts.
+    */
+    template <typename Storage, typename T>
+    struct is_implicit : std::bool_constant<is_grouped<Storage, T>::value || is_interval<Storage, T>::value> {};
+
+    template <typename Storage, typename T>
+    inline constexpr bool is_implicit_v = is_implicit<Storage, T>::value;
+
+    /*! \brief Hash function for the objects that carry a precomputed hash value, returned by their member function hash().
+    *
+        Using it with a stored value avoids computing the hash of the objects again each time a hash table of the instance grows.
+    */
+    template <typename T>
+    struct PrecomputedHash
+    {
+        size_t operator()(const T& object) const noexcept { return static_cast<size_t>(object.hash()); }
+    };
+
+    /*! \brief Storage of the conflict relationships in a Requirements::Requirements instance.
+    *
+        Each relationship is stored once as a requirement of its first object, so that lookups must be performed in both directions.
+        \warning Requirements::Requirements has no hash customization, only std::hash and std::equal_to are supported.
+    */
+    template <typename T, typename Hash = std::hash<T>, typename KeyEqual = std::equal_to<T>>
+    class RequirementsStorage
+    {
+        static_assert(std::is_same_v<Hash, std::hash<T>> && std::is_same_v<KeyEqual, std::equal_to<T>>,
+            "RequirementsEngine does not support custom Hash or KeyEqual.");
+
+    public:
+        void clear() noexcept { m_conflicts.clear(); }
+        void reserve(size_t) {}
+        bool empty() const noexcept { return m_conflicts.empty(); }
+        size_t size() const noexcept { return m_conflicts.size(); }
+
+        void add(const T& object1, const T& object2) { m_conflicts.add(object1, object2); }
+
+        bool remove(const T& object1, const T& object2)
+        {
+            // conflict definition is searched for the 2 directions (object, conflict) and (conflict, object)
+            bool found{ false };
+            if (m_conflicts.exists(object1, object2))
+            {
+                m_conflicts.remove(object1, object2);
+                found = true;
+            }
+            if (m_conflicts.exists(object2, object1))
+            {
+                m_conflicts.remove(object2, object1);
+                found = true;
+            }
+            return found;
+        }
+
+        void remove(const T& object) { m_conflicts.remove_all(object); }
+
+        bool exists(const T& object1, const T& object2) const noexcept
+        {
+            return m_conflicts.exists(object1, object2) || m_conflicts.exists(object2, object1);
+        }
+
+        bool contains(const T& object) const noexcept
+        {
+            return m_conflicts.has_requirements(object) || m_conflicts.has_dependents(object);
+        }
+
+        size_t degree(const T& object) const
+        {
+            size_t result{ 0 };
+            for_each_conflict(object, [&result](const T&) { ++result; return true; });
+            return result;
+        }
+
+        template <typename F>
+        bool for_each_conflict(const T& object, F&& f) const
+        {
+            for (auto& con : m_conflicts.requirements(object))
+                if (!f(con))
+                    return false;
+            for (auto& con : m_conflicts.dependents(object))
+                if (!f(con))
+                    return false;
+            return true;
+        }
+
+        template <typename F>
+        bool for_each_pair(F&& f) const
+        {
+            for (auto& pair : m_conflicts.get())
+                if (!f(pair.first, pair.second))
+                    return false;
+            return true;
+        }
+
+    private:
+        ::Requirements::Requirements<T> m_conflicts{ false };
+    };
+
+    /*! \brief Engine storing the relationships in a Requirements::Requirements instance. */
+    struct RequirementsEngine
+    {
+        template <typename T, typename Hash = std::hash<T>, typename KeyEqual = std::equal_to<T>>
+        using storage = RequirementsStorage<T, Hash, KeyEqual>;
+    };
+
+    /*! \brief Native storage of the undirected conflict relationships, with one set of neighbours per object.
+    *
+        Each relationship is stored in the neighbours of both objects, so that any lookup is a single probe.
+        The object given first at creation is flagged in order to keep the original direction of the pairs,
+        and the weight of the relationship is kept alongside.
+    */
+    template <typename T, typename Hash = std::hash<T>, typename KeyEqual = std::equal_to<T>>
+    class AdjacencyStorage
+    {
+    public:
+        void clear() noexcept { m_adjacency.clear(); m_size = 0; }
+        void reserve(size_t objects) { m_adjacency.reserve(objects); }
+        bool empty() const noexcept { return m_size == 0; }
+        size_t size() const noexcept { return m_size; }
+
+        void add(const T& object1, const T& object2) { add(object1, object2, DefaultWeight); }
+
+        void add(const T& object1, const T& object2, Weight weight)
+        {
+            m_adjacency[object1].emplace(object2, Link{ true, weight });
+            m_adjacency[object2].emplace(object1, Link{ false, weight });
+            ++m_size;
+        }
+
+        bool remove(const T& object1, const T& object2)
+        {
+            auto itr = m_adjacency.find(object1);
+            if (itr == m_adjacency.end() || itr->second.erase(object2) == 0)
+                return false;
+            if (itr->second.empty())
+                m_adjacency.erase(itr);
+            unlink(object2, object1);
+            --m_size;
+            return true;
+        }
+
+        void remove(const T& object)
+        {
+            auto itr = m_adjacency.find(object);
+            if (itr == m_adjacency.end())
+                return;
+            for (auto& con : itr->second)
+                unlink(con.first, object);
+            m_size -= itr->second.size();
+            m_adjacency.erase(itr);
+        }
+
+        bool exists(const T& object1, const T& object2) const noexcept
+        {
+            auto itr = m_adjacency.find(object1);
+            return itr != m_adjacency.end() && itr->second.count(object2) > 0;
+        }
+
+        bool contains(const T& object) const noexcept { return m_adjacency.count(object) > 0; }
+
+        size_t degree(const T& object) const
+        {
+            auto itr = m_adjacency.find(object);
+            return itr == m_adjacency.end() ? 0 : itr->second.size();
+        }
+
+        Weight weight(const T& object1, const T& object2) const
+        {
+            return m_adjacency.at(object1).at(object2).weight;
+        }
+
+        template <typename F>
+        bool for_each_weighted(const T& object, F&& f) const
+        {
+            auto itr = m_adjacency.find(object);
+            if (itr != m_adjacency.end())
+                for (auto& con : itr->second)
+                    if (!f(con.first, con.second.weight))
+                        return false;
+            return true;
+        }
+
+        template <typename F>
+        bool for_each_conflict(const T& object, F&& f) const
+        {
+            auto itr = m_adjacency.find(object);
+            if (itr != m_adjacency.end())
+                for (auto& con : itr->second)
+                    if (!f(con.first))
+                        return false;
+            return true;
+        }
+
+        template <typename F>
+        bool for_each_pair(F&& f) const
+        {
+            for (auto& object : m_adjacency)
+                for (auto& con : object.second)
+                    if (con.second.first && !f(object.first, con.first))
+                        return false;
+            return true;
+        }
+
+    private:
+        struct Link
+        {
+            bool first;         // set when the object was given first at creation
+            Weight weight;
+        };
+        // neighbours of an object
+        using neighbours_type = std::unordered_map<T, Link, Hash, KeyEqual>;
+
+        std::unordered_map<T, neighbours_type, Hash, KeyEqual> m_adjacency{};
+        size_t m_size{ 0 };
+
+        void unlink(const T& object, const T& con)
+        {
+            auto itr = m_adjacency.find(object);
+            itr->second.erase(con);
+            if (itr->second.empty())
+                m_adjacency.erase(itr);
+        }
+    };
+
+    /*! \brief Engine storing the relationships in a native adjacency structure. */
+    struct AdjacencyEngine
+    {
+        template <typename T, typename Hash = std::hash<T>, typename KeyEqual = std::equal_to<T>>
+        using storage = AdjacencyStorage<T, Hash, KeyEqual>;
+    };
+
+    /*! \brief Storage decorator that answers most negative lookups with a Bloom filter before probing the decorated storage.
+    *
+        The filter holds the relationships, as canonical pairs, and the objects involved in them. It is updated on additions;
+        removals leave obsolete keys that only cause false positives, and the filter is rebuilt once they are too many.
+        It speeds up exists() and contains(), thus in_conflict() when the relationships are sparse. As the filter only holds the relationships
+        added, it must decorate the storage of the relationships rather than a storage giving implicit conflicts, see is_implicit.
+    */
+    template <typename Storage, typename T, typename Hash = std::hash<T>>
+    class FilteredStorage
+    {
+        static_assert(!is_implicit_v<Storage, T>, "The filter would miss the implicit conflicts, it must be decorated instead.");
+
+    public:
+        void clear() noexcept { m_storage.clear(); m_filter.clear(); m_keys = 0; m_stale = 0; }
+
+        void reserve(size_t objects)
+        {
+            m_storage.reserve(objects);
+            if (objects * 2 > m_filter.capacity())
+                rebuild(objects * 2);
+        }
+
+        bool empty() const noexcept { return m_storage.empty(); }
+        size_t size() const noexcept { return m_storage.size(); }
+
+        void add(const T& object1, const T& object2)
+        {
+            m_storage.add(object1, object2);
+            insert(object1, object2);
+            if (m_keys > m_filter.capacity())
+                rebuild(m_keys * 2);
+        }
+
+        bool remove(const T& object1, const T& object2)
+        {
+            if (!m_storage.remove(object1, object2))
+                return false;
+            ++m_stale;
+            refresh();
+            return true;
+        }
+
+        void remove(const T& object)
+        {
+            m_stale += m_storage.degree(object) + 1;
+            m_storage.remove(object);
+            refresh();
+        }
+
+        bool exists(const T& object1, const T& object2) const noexcept
+        {
+            return m_filter.may_contain(pair_hash(object1, object2)) && m_storage.exists(object1, object2);
+        }
+
+        bool contains(const T& object) const noexcept
+        {
+            return m_filter.may_contain(object_hash(object)) && m_storage.contains(object);
+        }
+
+        size_t degree(const T& object) const { return m_storage.degree(object); }
+
+        template <typename F>
+        bool for_each_conflict(const T& object, F&& f) const { return m_storage.for_each_conflict(object, std::forward<F>(f)); }
+
+        template <typename F>
+        bool for_each_pair(F&& f) const { return m_storage.for_each_pair(std::forward<F>(f)); }
+
+        template <typename S = Storage, typename = std::enable_if_t<is_weighted_v<S, T>>>
+        void add(const T& object1, const T& object2, Weight weight)
+        {
+            m_storage.add(object1, object2, weight);
+            insert(object1, object2);
+            if (m_keys > m_filter.capacity())
+                rebuild(m_keys * 2);
+        }
+
+        template <typename S = Storage, typename = std::enable_if_t<is_weighted_v<S, T>>>
+        Weight weight(const T& object1, const T& object2) const { return m_storage.weight(object1, object2); }
+
+        template <typename F, typename S = Storage, typename = std::enable_if_t<is_weighted_v<S, T>>>
+        bool for_each_weighted(const T& object, F&& f) const { return m_storage.for_each_weighted(object, std::forward<F>(f)); }
+
+    private:
+        Storage m_storage{};
+        BlockedBloomFilter m_filter{};
+        size_t m_keys{ 0 };         // keys inserted since the last rebuild
+        size_t m_stale{ 0 };        // keys made obsolete by removals since the last rebuild
+
+        static uint64_t object_hash(const T& object) noexcept { return mix_hash(static_cast<uint64_t>(Hash{}(object))); }
+
+        // symmetric, so that both directions of a relationship give the same key
+        static uint64_t pair_hash(const T& object1, const T& object2) noexcept
+        {
+            uint64_t hash1 = object_hash(object1), hash2 = object_hash(object2);
+            return mix_hash(std::min(hash1, hash2) ^ mix_hash(std::max(hash1, hash2) + 0x9E3779B97F4A7C15ull));
+        }
+
+        void insert(const T& object1, const T& object2)
+        {
+            m_filter.insert(pair_hash(object1, object2));
+            m_filter.insert(object_hash(object1));
+            m_filter.insert(object_hash(object2));
+            m_keys += 3;
+        }
+
+        void refresh()
+        {
+            if (m_stale * 2 > m_keys)
+                rebuild(m_storage.size() * 6);
+        }
+
+        void rebuild(size_t capacity)
+        {
+            m_filter.resize(capacity);
+            m_keys = 0;
+            m_stale = 0;
+            m_storage.for_each_pair([this](const T& object1, const T& object2) { insert(object1, object2); return true; });
+        }
+    };
+
+    /*! \brief Engine decorating the storage of another engine with a Bloom filter, see FilteredStorage. */
+    template <typename Engine = AdjacencyEngine>
+    struct FilteredEngine
+    {
+        template <typename T, typename Hash = std::hash<T>, typename KeyEqual = std::equal_to<T>>
+        using storage = FilteredStorage<typename Engine::template storage<T, Hash, KeyEqual>, T, Hash>;
+    };
+
+    /*! \brief Storage decorator that keeps the objects ranked by degree as the relationships are added and removed.
+    *
+        The most conflicted objects are then listed in O(k) by top(), see Ranking. As only the relationships added are counted, the ranking
+        must decorate the storage of the relationships rather than a storage giving implicit conflicts, see is_implicit.
+    */
+    template <typename Storage, typename T, typename Hash = std::hash<T>, typename KeyEqual = std::equal_to<T>>
+    class RankedStorage
+    {
+        static_assert(!is_implicit_v<Storage, T>, "The ranking would miss the implicit conflicts, it must be decorated instead.");
+
+    public:
+        void clear() noexcept { m_storage.clear(); m_degrees.clear(); }
+        void reserve(size_t objects) { m_storage.reserve(objects); }
+        bool empty() const noexcept { return m_storage.empty(); }
+        size_t size() const noexcept { return m_storage.size(); }
+
+        void add(const T& object1, const T& object2)
+        {
+            m_storage.add(object1, object2);
+            m_degrees.adjust(object1, 1);
+            m_degrees.adjust(object2, 1);
+        }
+
+        bool remove(const T& object1, const T& object2)
+        {
+            if (!m_storage.remove(object1, object2))
+                return false;
+            m_degrees.adjust(object1, -1);
+            m_degrees.adjust(object2, -1);
+            return true;
+        }
+
+        void remove(const T& object)
+        {
+            m_storage.for_each_conflict(object, [this](const T& con) { m_degrees.adjust(con, -1); return true; });
+            m_degrees.adjust(object, -static_cast<std::ptrdiff_t>(m_degrees.count(object)));
+            m_storage.remove(object);
+        }
+
+        bool exists(const T& object1, const T& object2) const noexcept { return m_storage.exists(object1, object2); }
+        bool contains(const T& object) const noexcept { return m_storage.contains(object); }
+        size_t degree(const T& object) const { return m_degrees.count(object); }
+
+        template <typename F>
+        bool for_each_conflict(const T& object, F&& f) const { return m_storage.for_each_conflict(object, std::forward<F>(f)); }
+
+        template <typename F>
+        bool for_each_pair(F&& f) const { return m_storage.for_each_pair(std::forward<F>(f)); }
+
+        template <typename S = Storage, typename = std::enable_if_t<is_weighted_v<S, T>>>
+        void add(const T& object1, const T& object2, Weight weight)
+        {
+            m_storage.add(object1, object2, weight);
+            m_degrees.adjust(object1, 1);
+            m_degrees.adjust(object2, 1);
+        }
+
+        template <typename S = Storage, typename = std::enable_if_t<is_weighted_v<S, T>>>
+        Weight weight(const T& object1, const T& object2) const { return m_storage.weight(object1, object2); }
+
+        template <typename F, typename S = Storage, typename = std::enable_if_t<is_weighted_v<S, T>>>
+        bool for_each_weighted(const T& object, F&& f) const { return m_storage.for_each_weighted(object, std::forward<F>(f)); }
+
+        /*! \brief Lists the objects with the most direct relationships, by decreasing degree. */
+        std::vector<std::pair<T, size_t>> top(size_t k) const { return m_degrees.top(k); }
+
+    private:
+        Storage m_storage{};
+        Ranking<T, Hash, KeyEqual> m_degrees{};
+    };
+
+    /*! \brief Engine decorating the storage of another engine with a ranking of the objects by degree, see RankedStorage. */
+    template <typename Engine = AdjacencyEngine>
+    struct RankedEngine
+    {
+        template <typename T, typename Hash = std::hash<T>, typename KeyEqual = std::equal_to<T>>
+        using storage = RankedStorage<typename Engine::template storage<T, Hash, KeyEqual>, T, Hash, KeyEqual>;
+    };
+
+    /*! \brief Checks if a storage keeps its objects ranked by degree, providing std::vector< std::pair< T, size_t > > top(size_t) const. */
+    template <typename Storage, typename T, typename = void>
+    struct is_ranked : std::false_type {};
+
+    template <typename Storage, typename T>
+    struct is_ranked<Storage, T, std::void_t<decltype(std::declval<const Storage&>().top(size_t{}))>> : std::true_type {};
+
+    template <typename Storage, typename T>
+    inline constexpr bool is_ranked_v = is_ranked<Storage, T>::value;
+
+    /*! \brief Storage decorator adding conflicts between groups of objects, each member of a group being in conflict with each member of the other.
+    *
+        A rule between two groups is stored once, whatever the number of members, and the memberships are kept by object and by group,
+        so that a change of membership does not touch any relationship. The rules are expanded on the fly: exists() intersects the groups
+        ruled against the groups of the first object with the groups of the second one, and for_each_conflict() lists the members of the
+        groups ruled against the groups of the object. A rule between a group and itself sets all its members in conflict with each other.
+        An object is never in conflict with itself, and a pair given by several rules or by a relationship of the decorated storage is seen once.
+        The relationships of the decorated storage are added and removed as usual, a conflict given by a rule being only removed by changing
+        the rules or the memberships. The number of relationships is kept up to date: a change of the groups or of the rules counts the
+        conflicts only given by the rules around the members concerned, before and after the change.
+    */
+    template <typename Storage, typename T, typename Hash = std::hash<T>, typename KeyEqual = std::equal_to<T>,
+        typename Group = std::string, typename GroupHash = std::hash<Group>>
+    class GroupedStorage
+    {
+    public:
+        using group_type = Group;
+
+        void clear() noexcept { m_storage.clear(); m_groups.clear(); m_members.clear(); m_rules.clear(); m_count = 0; }
+        void reserve(size_t objects) { m_storage.reserve(objects); }
+        bool empty() const noexcept { return m_count == 0; }
+        size_t size() const noexcept { return m_count; }
+
+        void add(const T& object1, const T& object2)
+        {
+            m_storage.add(object1, object2);
+            counted(object1, object2, 1);
+        }
+
+        bool remove(const T& object1, const T& object2)
+        {
+            if (!m_storage.remove(object1, object2))
+                return false;
+            counted(object1, object2, -1);
+            return true;
+        }
+
+        /*! \brief Removes all the relationships of an object and its memberships. */
+        void remove(const T& object)
+        {
+            m_count -= degree(object);
+            m_storage.remove(object);
+            auto itr = m_groups.find(object);
+            if (itr != m_groups.end())
+            {
+                for (auto& group : itr->second)
+                    drop(group, object);
+                m_groups.erase(itr);
+            }
+        }
+
+        bool exists(const T& object1, const T& object2) const { return m_storage.exists(object1, object2) || ruled(object1, object2); }
+
+        bool contains(const T& object) const
+        {
+            if (m_storage.contains(object))
+                return true;
+            return !for_each_ruled(object, [&object](const Group&, const members_type& members)
+                {
+                    return members.size() == 1 && KeyEqual{}(*members.begin(), object);
+                });
+        }
+
+        size_t degree(const T& object) const
+        {
+            size_t result{ 0 };
+            for_each_conflict(object, [&result](const T&) { ++result; return true; });
+            return result;
+        }
+
+        template <typename F>
+        bool for_each_conflict(const T& object, F&& f) const
+        {
+            if (m_groups.count(object) == 0)
+                return m_storage.for_each_conflict(object, std::forward<F>(f));
+            std::unordered_set<T, Hash, KeyEqual> seen{ object };
+            if (!m_storage.for_each_conflict(object, [&](const T& con) { seen.insert(con); return f(con); }))
+                return false;
+            return for_each_ruled(object, [&](const Group&, const members_type& members)
+                {
+                    for (auto& con : members)
+                        if (seen.insert(con).second && !f(con))
+                            return false;
+                    return true;
+                });
+        }
+
+        template <typename F>
+        bool for_each_pair(F&& f) const
+        {
+            if (!m_storage.for_each_pair(f))
+                return false;
+            // a pair given by rules is listed from the first of its objects visited, except if the decorated storage holds it
+            std::unordered_set<T, Hash, KeyEqual> done{};
+            for (auto& object : m_groups)
+            {
+                std::unordered_set<T, Hash, KeyEqual> seen{ object.first };
+                bool go = for_each_ruled(object.first, [&](const Group&, const members_type& members)
+                    {
+                        for (auto& con : members)
+                            if (done.count(con) == 0 && seen.insert(con).second && !m_storage.exists(object.first, con) && !f(object.first, con))
+                                return false;
+                        return true;
+                    });
+                if (!go)
+                    return false;
+                done.insert(object.first);
+            }
+            return true;
+        }
+
+        template <typename S = Storage, typename = std::enable_if_t<is_weighted_v<S, T>>>
+        void add(const T& object1, const T& object2, Weight weight)
+        {
+            m_storage.add(object1, object2, weight);
+            counted(object1, object2, 1);
+        }
+
+        /*! \brief Gets the weight of a relationship, DefaultWeight for a conflict only given by rules. */
+        template <typename S = Storage, typename = std::enable_if_t<is_weighted_v<S, T>>>
+        Weight weight(const T& object1, const T& object2) const
+        {
+            return m_storage.exists(object1, object2) ? m_storage.weight(object1, object2) : DefaultWeight;
+        }
+
+        template <typename F, typename S = Storage, typename = std::enable_if_t<is_weighted_v<S, T>>>
+        bool for_each_weighted(const T& object, F&& f) const
+        {
+            if (m_groups.count(object) == 0)
+                return m_storage.for_each_weighted(object, std::forward<F>(f));
+            std::unordered_set<T, Hash, KeyEqual> seen{ object };
+            if (!m_storage.for_each_weighted(object, [&](const T& con, Weight weight) { seen.insert(con); return f(con, weight); }))
+                return false;
+            return for_each_ruled(object, [&](const Group&, const members_type& members)
+                {
+                    for (auto& con : members)
+                        if (seen.insert(con).second && !f(con, DefaultWeight))
+                            return false;
+                    return true;
+                });
+        }
+
+        /*! \brief Adds an object to a group, returns false if it already belongs to it. */
+        bool join(const T& object, const Group& group)
+        {
+            if (member(object, group))
+                return false;
+            size_t before = ruled_degree(object);
+            m_groups[object].insert(group);
+            m_members[group].insert(object);
+            m_count += ruled_degree(object) - before;
+            return true;
+        }
+
+        /*! \brief Removes an object from a group, returns false if it does not belong to it. */
+        bool leave(const T& object, const Group& group)
+        {
+            if (!member(object, group))
+                return false;
+            size_t before = ruled_degree(object);
+            auto itr = m_groups.find(object);
+            itr->second.erase(group);
+            if (itr->second.empty())
+                m_groups.erase(itr);
+            drop(group, object);
+            m_count -= before - ruled_degree(object);
+            return true;
+        }
+
+        /*! \brief Sets the members of two groups in conflict, returns false if the rule already exists. */
+        bool add_rule(const Group& group1, const Group& group2)
+        {
+            if (has_rule(group1, group2))
+                return false;
+            size_t before = ruled_degrees(group1, group2);
+            m_rules[group1].insert(group2);
+            m_rules[group2].insert(group1);
+            m_count += (ruled_degrees(group1, group2) - before) / 2;
+            return true;
+        }
+
+        /*! \brief Removes the rule between two groups, returns false if it does not exist. */
+        bool remove_rule(const Group& group1, const Group& group2)
+        {
+            if (!has_rule(group1, group2))
+                return false;
+            size_t before = ruled_degrees(group1, group2);
+            auto itr = m_rules.find(group1);
+            itr->second.erase(group2);
+            if (itr->second.empty())
+                m_rules.erase(itr);
+            if ((itr = m_rules.find(group2)) != m_rules.end())
+            {
+                itr->second.erase(group1);
+                if (itr->second.empty())
+                    m_rules.erase(itr);
+            }
+            m_count -= (before - ruled_degrees(group1, group2)) / 2;
+            return true;
+        }
+
+        /*! \brief Checks if a rule exists between two groups. */
+        bool has_rule(const Group& group1, const Group& group2) const
+        {
+            auto itr = m_rules.find(group1);
+            return itr != m_rules.end() && itr->second.count(group2) > 0;
+        }
+
+        /*! \brief Checks if an object belongs to a group. */
+        bool member(const T& object, const Group& group) const
+        {
+            auto itr = m_groups.find(object);
+            return itr != m_groups.end() && itr->second.count(group) > 0;
+        }
+
+    private:
+        using groups_type = std::unordered_set<Group, GroupHash>;
+        using members_type = std::unordered_set<T, Hash, KeyEqual>;
+
+        Storage m_storage{};
+        std::unordered_map<T, groups_type, Hash, KeyEqual> m_groups{};         // groups of each object
+        std::unordered_map<Group, members_type, GroupHash> m_members{};         // members of each group
+        std::unordered_map<Group, groups_type, GroupHash> m_rules{};            // groups ruled against each group, in both directions
+        size_t m_count{ 0 };                                                    // number of relationships
+
+        // keeps the number of relationships after a change of the decorated storage, a pair given by rules being counted once
+        void counted(const T& object1, const T& object2, int delta)
+        {
+            if (!ruled(object1, object2))
+                m_count += delta;
+        }
+
+        // counts the objects only in conflict with an object by the rules
+        size_t ruled_degree(const T& object) const
+        {
+            size_t result{ 0 };
+            std::unordered_set<T, Hash, KeyEqual> seen{ object };
+            for_each_ruled(object, [&](const Group&, const members_type& members)
+                {
+                    for (auto& con : members)
+                        if (seen.insert(con).second && !m_storage.exists(object, con))
+                            ++result;
+                    return true;
+                });
+            return result;
+        }
+
+        // sums the conflicts only given by the rules of the members of two groups, a pair between members being counted from both sides
+        size_t ruled_degrees(const Group& group1, const Group& group2) const
+        {
+            size_t result{ 0 };
+            std::unordered_set<T, Hash, KeyEqual> done{};
+            for (const Group* group : { &group1, &group2 })
+            {
+                auto members = m_members.find(*group);
+                if (members != m_members.end())
+                    for (auto& object : members->second)
+                        if (done.insert(object).second)
+                            result += ruled_degree(object);
+            }
+            return result;
+        }
+
+        void drop(const Group& group, const T& object)
+        {
+            auto itr = m_members.find(group);
+            itr->second.erase(object);
+            if (itr->second.empty())
+                m_members.erase(itr);
+        }
+
+        // calls F with each group ruled against a group of the object, that has members, and these members
+        template <typename F>
+        bool for_each_ruled(const T& object, F&& f) const
+        {
+            auto groups = m_groups.find(object);
+            if (groups == m_groups.end())
+                return true;
+            for (auto& group : groups->second)
+            {
+                auto rules = m_rules.find(group);
+                if (rules == m_rules.end())
+                    continue;
+                for (auto& other : rules->second)
+                {
+                    auto members = m_members.find(other);
+                    if (members != m_members.end() && !f(other, members->second))
+                        return false;
+                }
+            }
+            return true;
+        }
+
+        bool ruled(const T& object1, const T& object2) const
+        {
+            if (KeyEqual{}(object1, object2))
+                return false;
+            auto groups = m_groups.find(object2);
+            if (groups == m_groups.end())
+                return false;
+            return !for_each_ruled(object1, [&groups](const Group& other, const members_type&) { return groups->second.count(other) == 0; });
+        }
+    };
+
+    /*! \brief Engine decorating the storage of another engine with conflicts between groups of objects, see GroupedStorage.
+    *
+        Group identifies the groups, hashed by GroupHash.
+        \warning Rules form cycles, so that no component index is kept in cascading mode: each cascading query is a breadth first search
+        of all the objects reachable, expanding the rules of each one, without any bound but the number of objects.
+    */
+    template <typename Engine = AdjacencyEngine, typename Group = std::string, typename GroupHash = std::hash<Group>>
+    struct GroupedEngine
+    {
+        template <typename T, typename Hash = std::hash<T>, typename KeyEqual = std::equal_to<T>>
+        using storage = GroupedStorage<typename Engine::template storage<T, Hash, KeyEqual>, T, Hash, KeyEqual, Group, GroupHash>;
+    };
+
+    /*! \brief Checks if a storage supports conflicts between groups, providing the type group_type,
+    *   bool join(const T&, const group_type&), bool leave(const T&, const group_type&), bool add_rule(const group_type&, const group_type&)
+    *   and bool remove_rule(const group_type&, const group_type&), see GroupedStorage.
+    */
+    template <typename Storage, typename T, typename>
+    struct is_grouped : std::false_type {};
+
+    template <typename Storage, typename T>
+    struct is_grouped<Storage, T, std::void_t<
+        typename Storage::group_type,
+        decltype(static_cast<bool>(std::declval<Storage&>().join(std::declval<const T&>(), std::declval<const typename Storage::group_type&>()))),
+        decltype(static_cast<bool>(std::declval<Storage&>().leave(std::declval<const T&>(), std::declval<const typename Storage::group_type&>()))),
+        decltype(static_cast<bool>(std::declval<Storage&>().add_rule(std::declval<const typename Storage::group_type&>(),
+            std::declval<const typename Storage::group_type&>()))),
+        decltype(static_cast<bool>(std::declval<Storage&>().remove_rule(std::declval<const typename Storage::group_type&>(),
+            std::declval<const typename Storage::group_type&>())))
+    >> : std::true_type {};
+
+    template <typename Storage, typename T>
+    inline constexpr bool is_grouped_v = is_grouped<Storage, T>::value;
+
+    /*! \brief Storage decorator adding implicit conflicts between the objects whose intervals overlap, such as reservations.
+    *
+        The objects may be given a half-open interval [start, end), kept in an IntervalTree, and two objects are in conflict when their
+        intervals overlap. No relationship is stored for them: exists() compares both intervals in constant time, and for_each_conflict()
+        lists the k intervals overlapping the one of the object in O(min(n, k log n)). A pair whose intervals overlap and that is also held by
+        the decorated storage is seen once. The number of pairs that are only given by intervals is kept up to date, so that size() is
+        read in constant time. Intervals are changed by set_interval() and remove_interval() only, removing an object removing its interval.
+    */
+    template <typename Storage, typename T, typename Hash = std::hash<T>, typename KeyEqual = std::equal_to<T>, typename Position = double>
+    class IntervalStorage
+    {
+    public:
+        using position_type = Position;
+
+        void clear() noexcept { m_storage.clear(); m_intervals.clear(); m_implicit = 0; }
+        void reserve(size_t objects) { m_storage.reserve(objects); }
+        bool empty() const noexcept { return size() == 0; }
+        size_t size() const noexcept { return m_storage.size() + m_implicit; }
+
+        void add(const T& object1, const T& object2)
+        {
+            m_storage.add(object1, object2);
+            m_implicit -= overlap(object1, object2);
+        }
+
+        bool remove(const T& object1, const T& object2)
+        {
+            if (!m_storage.remove(object1, object2))
+                return false;
+            m_implicit += overlap(object1, object2);
+            return true;
+        }
+
+        /*! \brief Removes all the relationships of an object and its interval. */
+        void remove(const T& object)
+        {
+            remove_interval(object);
+            m_storage.remove(object);
+        }
+
+        bool exists(const T& object1, const T& object2) const { return overlap(object1, object2) || m_storage.exists(object1, object2); }
+
+        bool contains(const T& object) const
+        {
+            return m_storage.contains(object) || !for_each_overlap(object, [](const T&) { return false; });
+        }
+
+        size_t degree(const T& object) const
+        {
+            size_t result = m_storage.degree(object);
+            for_each_overlap(object, [&](const T& con) { result += !m_storage.exists(object, con); return true; });
+            return result;
+        }
+
+        template <typename F>
+        bool for_each_conflict(const T& object, F&& f) const
+        {
+            if (!m_storage.for_each_conflict(object, f))
+                return false;
+            return for_each_overlap(object, [&](const T& con) { return m_storage.exists(object, con) || f(con); });
+        }
+
+        template <typename F>
+        bool for_each_pair(F&& f) const
+        {
+            if (!m_storage.for_each_pair(f))
+                return false;
+            return m_intervals.for_each_pair([&](const T& object1, const T& object2) { return m_storage.exists(object1, object2) || f(object1, object2); });
+        }
+
+        template <typename S = Storage, typename = std::enable_if_t<is_weighted_v<S, T>>>
+        void add(const T& object1, const T& object2, Weight weight)
+        {
+            m_storage.add(object1, object2, weight);
+            m_implicit -= overlap(object1, object2);
+        }
+
+        /*! \brief Gets the weight of a relationship, DefaultWeight for a conflict only given by intervals. */
+        template <typename S = Storage, typename = std::enable_if_t<is_weighted_v<S, T>>>
+        Weight weight(const T& object1, const T& object2) const
+        {
+            return m_storage.exists(object1, object2) ? m_storage.weight(object1, object2) : DefaultWeight;
+        }
+
+        template <typename F, typename S = Storage, typename = std::enable_if_t<is_weighted_v<S, T>>>
+        bool for_each_weighted(const T& object, F&& f) const
+        {
+            if (!m_storage.for_each_weighted(object, f))
+                return false;
+            return for_each_overlap(object, [&](const T& con) { return m_storage.exists(object, con) || f(con, DefaultWeight); });
+        }
+
+        /*! \brief Sets the interval of an object, replacing its former one.
+        *   \param object the object
+        *   \param start,end the bounds of the half-open interval, an empty one only removing the former interval
+        */
+        void set_interval(const T& object, const Position& start, const Position& end)
+        {
+            remove_interval(object);
+            if (!(start < end))
+                return;
+            m_intervals.insert(object, start, end);
+            m_implicit += implicit(object);
+        }
+
+        /*! \brief Removes the interval of an object, returns false if it has none. */
+        bool remove_interval(const T& object)
+        {
+            if (m_intervals.find(object) == nullptr)
+                return false;
+            m_implicit -= implicit(object);
+            m_intervals.erase(object);
+            return true;
+        }
+
+        /*! \brief Gets the interval of an object, nullptr if it has none. */
+        const std::pair<Position, Position>* interval(const T& object) const { return m_intervals.find(object); }
+
+    private:
+        Storage m_storage{};
+        IntervalTree<T, Position, Hash, KeyEqual> m_intervals{};
+        size_t m_implicit{ 0 };                                    // overlapping pairs not held by the decorated storage
+
+        bool overlap(const T& object1, const T& object2) const
+        {
+            if (KeyEqual{}(object1, object2))
+                return false;
+            auto interval1 = m_intervals.find(object1), interval2 = m_intervals.find(object2);
+            return interval1 != nullptr && interval2 != nullptr && m_intervals.overlap(*interval1, *interval2);
+        }
+
+        // calls F with each other object whose interval overlaps the one of the object
+        template <typename F>
+        bool for_each_overlap(const T& object, F&& f) const
+        {
+            auto interval = m_intervals.find(object);
+            if (interval == nullptr)
+                return true;
+            return m_intervals.for_each_overlap(interval->first, interval->second, [&](const T& con) { return KeyEqual{}(con, object) || f(con); });
+        }
+
+        // number of pairs of an object only given by its interval
+        size_t implicit(const T& object) const
+        {
+            size_t result{ 0 };
+            for_each_overlap(object, [&](const T& con) { result += !m_storage.exists(object, con); return true; });
+            return result;
+        }
+    };
+
+    /*! \brief Engine decorating the storage of another engine with conflicts between the objects whose intervals overlap, see IntervalStorage.
+    *
+        Position gives the bounds of the intervals, such as a time.
+        \warning Overlaps form cycles, so that no component index is kept in cascading mode: each cascading query is a breadth first search
+        of all the objects reachable, listing the overlaps of each one, without any bound but the number of objects.
+    */
+    template <typename Engine = AdjacencyEngine, typename Position = double>
+    struct IntervalEngine
+    {
+        template <typename T, typename Hash = std::hash<T>, typename KeyEqual = std::equal_to<T>>
+        using storage = IntervalStorage<typename Engine::template storage<T, Hash, KeyEqual>, T, Hash, KeyEqual, Position>;
+    };
+
+    /*! \brief Checks if a storage sets in conflict the objects whose intervals overlap, providing the type position_type,
+    *   void set_interval(const T&, const position_type&, const position_type&) and bool remove_interval(const T&), see IntervalStorage.
+    */
+    template <typename Storage, typename T, typename>
+    struct is_interval : std::false_type {};
+
+    template <typename Storage, typename T>
+    struct is_interval<Storage, T, std::void_t<
+        typename Storage::position_type,
+        decltype(std::declval<Storage&>().set_interval(std::declval<const T&>(), std::declval<const typename Storage::position_type&>(),
+            std::declval<const typename Storage::position_type&>())),
+        decltype(static_cast<bool>(std::declval<Storage&>().remove_interval(std::declval<const T&>())))
+    >> : std::true_type {};
+
+    template <typename Storage, typename T>
+    inline constexpr bool is_interval_v = is_interval<Storage, T>::value;
+
+    /*! \brief Storage decorator whose relationships may expire after a time to live.
+    *
+        The relationships added with a time to live are scheduled in a TimerWheel ticking at the resolution of the Clock, and their deadline
+        is kept by pair. The changes of the storage, and expire(), advance the wheel to the current time and remove the relationships that
+        expired, without any scan. A timer left by a relationship removed or created again before its deadline is ignored.
+        The queries never change the storage: they read the clock once and skip the relationships whose deadline is reached, see View.
+        The decorator must be the outermost one, so that the decorated storages see the expired relationships removed.
+    */
+    template <typename Storage, typename T, typename Hash = std::hash<T>, typename KeyEqual = std::equal_to<T>,
+        typename Clock = std::chrono::steady_clock>
+    class ExpiringStorage
+    {
+        // deadlines of the relationships of an object that expire
+        using deadlines_type = std::unordered_map<T, uint64_t, Hash, KeyEqual>;
+
+    public:
+        using clock = Clock;
+        using duration = typename Clock::duration;
+
+        /*! \brief Read-only view of the relationships of an ExpiringStorage at a time point, implementing the queries of the storage interface.
+        *
+            The relationships whose deadline is reached at the time point are skipped. When no pending deadline is reached, the queries are
+            forwarded as is; otherwise degree() and contains() cost the number of expiring relationships of the object, and size() and top()
+            the number of expiring relationships. The view must not outlive its storage, nor be used across a change of it.
+        */
+        class View
+        {
+        public:
+            View(const ExpiringStorage& storage, typename Clock::time_point time) noexcept
+                : m_storage(storage), m_tick(storage.tick(time)), m_stale(storage.m_wheel.earliest() <= m_tick) {}
+
+            // view of a storage where no relationship is pending
+            explicit View(const ExpiringStorage& storage) noexcept : m_storage(storage), m_tick(0), m_stale(false) {}
+
+            bool empty() const { return size() == 0; }
+
+            size_t size() const
+            {
+                if (!m_stale)
+                    return m_storage.m_storage.size();
+                size_t expired{ 0 };
+                for (auto& item : m_storage.m_deadlines)
+                    expired += count(item.second);
+                return m_storage.m_storage.size() - expired / 2;
+            }
+
+            bool exists(const T& object1, const T& object2) const
+            {
+                if (!m_storage.m_storage.exists(object1, object2))
+                    return false;
+                auto itr = deadlines(object1);
+                return itr == m_storage.m_deadlines.end() || live(itr->second, object2);
+            }
+
+            bool contains(const T& object) const
+            {
+                if (!m_storage.m_storage.contains(object))
+                    return false;
+                return deadlines(object) == m_storage.m_deadlines.end() || degree(object) > 0;
+            }
+
+            size_t degree(const T& object) const
+            {
+                size_t result = m_storage.m_storage.degree(object);
+                auto itr = deadlines(object);
+                return itr == m_storage.m_deadlines.end() ? result : result - count(itr->second);
+            }
+
+            template <typename F>
+            bool for_each_conflict(const T& object, F&& f) const
+            {
+                auto itr = deadlines(object);
+                if (itr == m_storage.m_deadlines.end())
+                    return m_storage.m_storage.for_each_conflict(object, std::forward<F>(f));
+                return m_storage.m_storage.for_each_conflict(object, [this, &f, &cons = itr->second](const T& con) { return !live(cons, con) || f(con); });
+            }
+
+            template <typename F>
+            bool for_each_pair(F&& f) const
+            {
+                if (!m_stale)
+                    return m_storage.m_storage.for_each_pair(std::forward<F>(f));
+                return m_storage.m_storage.for_each_pair([this, &f](const T& object1, const T& object2) { return !live(object1, object2) || f(object1, object2); });
+            }
+
+            template <typename S = Storage, typename = std::enable_if_t<is_weighted_v<S, T>>>
+            Weight weight(const T& object1, const T& object2) const { return m_storage.m_storage.weight(object1, object2); }
+
+            template <typename F, typename S = Storage, typename = std::enable_if_t<is_weighted_v<S, T>>>
+            bool for_each_weighted(const T& object, F&& f) const
+            {
+                auto itr = deadlines(object);
+                if (itr == m_storage.m_deadlines.end())
+                    return m_storage.m_storage.for_each_weighted(object, std::forward<F>(f));
+                return m_storage.m_storage.for_each_weighted(object, [this, &f, &cons = itr->second](const T& con, Weight weight)
+                    {
+                        return !live(cons, con) || f(con, weight);
+                    });
+            }
+
+            /*! \brief Lists the objects with the most direct relationships, by decreasing degree.
+            *
+                The objects losing relationships at the time point are ranked again, the others keeping their rank in the storage.
+            */
+            template <typename S = Storage, typename = std::enable_if_t<is_ranked_v<S, T>>>
+            std::vector<std::pair<T, size_t>> top(size_t k) const
+            {
+                if (!m_stale)
+                    return m_storage.m_storage.top(k);
+                std::vector<std::pair<T, size_t>> result{};
+                std::unordered_set<T, Hash, KeyEqual> changed{};
+                for (auto& item : m_storage.m_deadlines)
+                {
+                    size_t expired = count(item.second);
+                    if (expired == 0)
+                        continue;
+                    changed.insert(item.first);
+                    if (size_t left = m_storage.m_storage.degree(item.first) - expired; left > 0)
+                        result.emplace_back(item.first, left);
+                }
+                // the objects ranked above the first k unchanged ones are either changed or among them
+                for (auto& item : m_storage.m_storage.top(std::min(k, std::numeric_limits<size_t>::max() - changed.size()) + changed.size()))
+                    if (changed.count(item.first) == 0)
+                        result.push_back(item);
+                k = std::min(k, result.size());
+                std::partial_sort(result.begin(), result.begin() + k, result.end(),
+                    [](const std::pair<T, size_t>& item1, const std::pair<T, size_t>& item2) { return item1.second > item2.second; });
+                result.resize(k);
+                return result;
+            }
+
+        private:
+            const ExpiringStorage& m_storage;
+            uint64_t m_tick;
+            bool m_stale;           // some pending deadline may be reached
+
+            typename std::unordered_map<T, deadlines_type, Hash, KeyEqual>::const_iterator deadlines(const T& object) const
+            {
+                return m_stale ? m_storage.m_deadlines.find(object) : m_storage.m_deadlines.end();
+            }
+
+            bool live(const deadlines_type& cons, const T& con) const
+            {
+                auto itr = cons.find(con);
+                return itr == cons.end() || itr->second > m_tick;
+            }
+
+            bool live(const T& object1, const T& object2) const
+            {
+                auto itr = deadlines(object1);
+                return itr == m_storage.m_deadlines.end() || live(itr->second, object2);
+            }
+
+            size_t count(const deadlines_type& cons) const
+            {
+                return static_cast<size_t>(std::count_if(cons.begin(), cons.end(), [this](const auto& item) { return item.second <= m_tick; }));
+            }
+        };
+
+        void clear() noexcept { m_storage.clear(); m_wheel.clear(); m_deadlines.clear(); }
+        void reserve(size_t objects) { m_storage.reserve(objects); }
+        bool empty() const { return current().empty(); }
+        size_t size() const { return current().size(); }
+
+        void add(const T& object1, const T& object2)
+        {
+            expire();
+            m_storage.add(object1, object2);
+        }
+
+        /*! \brief Adds a relationship removed once its time to live is elapsed.
+        *   \param object1,object2 the objects of the new relationship
+        *   \param ttl the time to live, the relationship being never seen if it is not positive
+        */
+        void add(const T& object1, const T& object2, duration ttl)
+        {
+            auto now = Clock::now();
+            advance(now);
+            m_storage.add(object1, object2);
+            schedule(object1, object2, now + ttl);
+        }
+
+        bool remove(const T& object1, const T& object2)
+        {
+            expire();
+            if (!m_storage.remove(object1, object2))
+                return false;
+            forget(object1, object2);
+            return true;
+        }
+
+        void remove(const T& object)
+        {
+            expire();
+            auto itr = m_deadlines.find(object);
+            if (itr != m_deadlines.end())
+            {
+                for (auto& con : itr->second)
+                    unschedule(con.first, object);
+                m_deadlines.erase(itr);
+            }
+            m_storage.remove(object);
+        }
+
+        bool exists(const T& object1, const T& object2) const { return current().exists(object1, object2); }
+        bool contains(const T& object) const { return current().contains(object); }
+        size_t degree(const T& object) const { return current().degree(object); }
+
+        template <typename F>
+        bool for_each_conflict(const T& object, F&& f) const { return current().for_each_conflict(object, std::forward<F>(f)); }
+
+        template <typename F>
+        bool for_each_pair(F&& f) const { return current().for_each_pair(std::forward<F>(f)); }
+
+        template <typename S = Storage, typename = std::enable_if_t<is_weighted_v<S, T>>>
+        void add(const T& object1, const T& object2, Weight weight)
+        {
+            expire();
+            m_storage.add(object1, object2, weight);
+        }
+
+        template <typename S = Storage, typename = std::enable_if_t<is_weighted_v<S, T>>>
+        Weight weight(const T& object1, const T& object2) const { return m_storage.weight(object1, object2); }
+
+        template <typename F, typename S = Storage, typename = std::enable_if_t<is_weighted_v<S, T>>>
+        bool for_each_weighted(const T& object, F&& f) const { return current().for_each_weighted(object, std::forward<F>(f)); }
+
+        template <typename S = Storage, typename = std::enable_if_t<is_ranked_v<S, T>>>
+        std::vector<std::pair<T, size_t>> top(size_t k) const { return current().top(k); }
+
+        /*! \brief Gets a view of the relationships at a time point, so that the queries of an operation read the clock once. */
+        View at(typename Clock::time_point time) const noexcept { return View{ *this, time }; }
+
+        /*! \brief Gets a view of the relationships at the current time, the clock being only read if some relationship may expire. */
+        View current() const { return m_wheel.empty() ? View{ *this } : at(Clock::now()); }
+
+        /*! \brief Removes the relationships whose time to live is elapsed. It is performed by every change of the storage. */
+        void expire()
+        {
+            if (!m_wheel.empty())
+                advance(Clock::now());
+        }
+
+        /*! \brief Removes the relationships whose deadline is reached at a time point.
+        *   \param time the time point, ignored if it is before the last one advanced to
+        */
+        void advance(typename Clock::time_point time)
+        {
+            if (m_wheel.empty())
+                return;
+            m_wheel.advance(tick(time), [this](uint64_t deadline, std::pair<T, T>& pair)
+                {
+                    auto itr = m_deadlines.find(pair.first);
+                    if (itr == m_deadlines.end())
+                        return;
+                    auto con = itr->second.find(pair.second);
+                    if (con == itr->second.end() || con->second != deadline)
+                        return;
+                    forget(pair.first, pair.second);
+                    m_storage.remove(pair.first, pair.second);
+                });
+        }
+
+    private:
+        Storage m_storage{};
+        TimerWheel<std::pair<T, T>> m_wheel{};
+        std::unordered_map<T, deadlines_type, Hash, KeyEqual> m_deadlines{};
+        typename Clock::time_point m_origin{ Clock::now() };       // tick 0 of the wheel
+
+        uint64_t tick(typename Clock::time_point time) const noexcept
+        {
+            auto elapsed = (time - m_origin).count();
+            return elapsed > 0 ? static_cast<uint64_t>(elapsed) : 0;
+        }
+
+        void schedule(const T& object1, const T& object2, typename Clock::time_point time)
+        {
+            uint64_t deadline = tick(time);
+            m_deadlines[object1][object2] = deadline;
+            m_deadlines[object2][object1] = deadline;
+            m_wheel.schedule(deadline, std::make_pair(object1, object2));
+        }
+
+        void forget(const T& object1, const T& object2)
+        {
+            unschedule(object1, object2);
+            unschedule(object2, object1);
+        }
+
+        void unschedule(const T& object, const T& con)
+        {
+            auto itr = m_deadlines.find(object);
+            if (itr == m_deadlines.end())
+                return;
+            itr->second.erase(con);
+            if (itr->second.empty())
+                m_deadlines.erase(itr);
+        }
+    };
+
+    /*! \brief Engine decorating the storage of another engine with relationships that expire, see ExpiringStorage.
+    *
+        Clock gives the current time, any type meeting the requirements of the standard clocks being supported.
+    */
+    template <typename Engine = AdjacencyEngine, typename Clock = std::chrono::steady_clock>
+    struct ExpiringEngine
+    {
+        template <typename T, typename Hash = std::hash<T>, typename KeyEqual = std::equal_to<T>>
+        using storage = ExpiringStorage<typename Engine::template storage<T, Hash, KeyEqual>, T, Hash, KeyEqual, Clock>;
+    };
+
+    /*! \brief Checks if the relationships of a storage may expire, providing void add(const T&, const T&, duration) with a time to live,
+    *   void expire() and View at(time_point) const, see ExpiringStorage.
+    */
+    template <typename Storage, typename T, typename = void>
+    struct is_expiring : std::false_type {};
+
+    template <typename Storage, typename T>
+    struct is_expiring<Storage, T, std::void_t<
+        typename Storage::duration,
+        decltype(std::declval<Storage&>().expire()),
+        decltype(std::declval<const Storage&>().at(Storage::clock::now())),
+        decltype(std::declval<Storage&>().add(std::declval<const T&>(), std::declval<const T&>(), std::declval<typename Storage::duration>()))
+    >> : std::true_type {};
+
+    template <typename Storage, typename T>
+    inline constexpr bool is_expiring_v = is_expiring<Storage, T>::value;
+
+    /*! \brief Engine used when none is specified. */
+    using DefaultEngine = AdjacencyEngine;
+
+}
@@ -0,0 +1,427 @@
+#pragma once
+
+/*! \file conflicts_executor.hpp
+*	\brief Implements the template class ConflictExecutor, that runs jobs concurrently without ever running two conflicting ones together.
+*   \author Christophe COUAILLET
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "conflicts.hpp"
+#include "conflicts_capacity.hpp"
+
+namespace Conflicts
+{
+
+    /*! \brief Class WorkStealingPool runs tasks on a fixed number of threads, each with its own queue.
+    *
+        A task pushed by a thread of the pool goes to the queue of this thread, the other ones being spread over the queues in turn.
+        Each queue has its own mutex: a thread takes the oldest task of its queue, then steals the newest task of the other queues,
+        locking one of them at a time, when its own one is empty. The number of queued tasks is kept in an atomic counter, and a thread
+        only takes the sleep mutex to wait while it is null. The tasks still queued at destruction are run before the threads are joined.
+    */
+    class WorkStealingPool
+    {
+    public:
+        using task_type = std::function<void()>;
+
+        /*! \brief Constructor.
+        *   \param threads the number of threads, at least 1
+        */
+        explicit WorkStealingPool(size_t threads = std::thread::hardware_concurrency())
+            : m_queues(std::max<size_t>(threads, 1))
+        {
+            m_threads.reserve(m_queues.size());
+            for (size_t index = 0; index < m_queues.size(); ++index)
+                m_threads.emplace_back([this, index] { work(index); });
+        }
+
+        WorkStealingPool(const WorkStealingPool&) = delete;
+        WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+        ~WorkStealingPool()
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_sleep);
+                m_stopping = true;
+            }
+            m_wakeup.notify_all();
+            for (auto& thread : m_threads)
+                thread.join();
+        }
+
+        /*! \brief Gets the number of threads. */
+        size_t size() const noexcept { return m_threads.size(); }
+
+        /*! \brief Queues a task. */
+        void push(task_type task)
+        {
+            size_t index = t_pool == this ? t_index : m_next++ % m_queues.size();
+            {
+                std::lock_guard<std::mutex> lock(m_queues[index].mutex);
+                m_queues[index].tasks.push_back(std::move(task));
+                ++m_queued;
+            }
+            // a thread checking the counter before sleeping holds the sleep mutex, so that the wakeup is not lost
+            {
+                std::lock_guard<std::mutex> lock(m_sleep);
+            }
+            m_wakeup.notify_one();
+        }
+
+    private:
+        struct Queue
+        {
+            std::mutex mutex;
+            std::deque<task_type> tasks;
+        };
+
+        std::vector<Queue> m_queues;
+        std::vector<std::thread> m_threads{};
+        std::mutex m_sleep{};
+        std::condition_variable m_wakeup{};
+        std::atomic<size_t> m_queued{ 0 };  // tasks in the queues, changed with the lock of their queue
+        bool m_stopping{ false };           // guarded by m_sleep
+        std::atomic<size_t> m_next{ 0 };
+
+        // pool and queue of the current thread
+        static inline thread_local const WorkStealingPool* t_pool{ nullptr };
+        static inline thread_local size_t t_index{ 0 };
+
+        // takes the oldest task of the own queue, or steals the newest one of another queue, returns false if all are empty
+        bool take(size_t index, task_type& task)
+        {
+            for (size_t offset = 0; offset < m_queues.size(); ++offset)
+            {
+                Queue& queue = m_queues[(index + offset) % m_queues.size()];
+                std::lock_guard<std::mutex> lock(queue.mutex);
+                if (queue.tasks.empty())
+                    continue;
+                if (offset == 0)
+                {
+                    task = std::move(queue.tasks.front());
+                    queue.tasks.pop_front();
+                }
+                else
+                {
+                    task = std::move(queue.tasks.back());
+                    queue.tasks.pop_back();
+                }
+                --m_queued;
+                return true;
+            }
+            return false;
+        }
+
+        void work(size_t index)
+        {
+            t_pool = this;
+            t_index = index;
+            while (true)
+            {
+                task_type task{};
+                if (take(index, task))
+                {
+                    task();
+                    continue;
+                }
+                // a scan only misses tasks taken meanwhile, or pushed to a queue already scanned, which the counter shows
+                std::unique_lock<std::mutex> lock(m_sleep);
+                m_wakeup.wait(lock, [this] { return m_queued > 0 || m_stopping; });
+                if (m_queued == 0)
+                    return;
+            }
+        }
+    };
+
+    /*! \brief Class ConflictExecutor runs jobs keyed by objects on a WorkStealingPool, never running together two jobs whose objects
+    *   are in conflict according to a Conflicts instance C.
+    *
+        A job is admitted only when no job of an object in conflict with its own one is running, the objects in conflict being the direct
+        ones, the ones within the depth, or the members of the same component in cascading mode. Jobs of the same object run one at a time,
+        in submission order. Optional capacity constraints also limit the number of their members running together, see CapacityConstraints.
+
+        Admission relies on running counters: without cascading, each object counts its running jobs and the running jobs of objects in
+        conflict with it, updated in O(deg) when a job starts or ends, so that checking a job is O(1). In cascading mode, each component
+        counts its running jobs, the components being labelled once when the executor leaves its idle state. When a job ends, only the
+        waiting jobs of the objects it was blocking, and of the members of its capacity constraints, are checked again. The jobs admitted
+        are handed to the pool once the state of the executor is unlocked.
+        \warning The relationships and the capacity constraints must not change while jobs are waiting or running. In cascading mode, the
+        changes made while the executor is idle are only seen from the next submission, that labels the components again.
+        No fairness is ensured between objects: a job may wait as long as objects in conflict keep being admitted.
+    */
+    template <typename C>
+    class ConflictExecutor
+    {
+    public:
+        using value_type = typename C::value_type;
+        using capacities_type = CapacityConstraints<value_type, typename C::hasher, typename C::key_equal>;
+        using job_type = std::function<void()>;
+
+        /*! \brief Constructor.
+        *   \param conflicts the relationships between the objects of the jobs, that must outlive the executor
+        *   \param threads the number of threads running the jobs
+        *   \param capacities optional capacity constraints on the objects of the jobs, whose counters are updated by the executor
+        */
+        explicit ConflictExecutor(const C& conflicts, size_t threads = std::thread::hardware_concurrency(), capacities_type* capacities = nullptr)
+            : m_conflicts(conflicts), m_capacities(capacities), m_pool(std::make_unique<WorkStealingPool>(threads)) {}
+
+        ConflictExecutor(const ConflictExecutor&) = delete;
+        ConflictExecutor& operator=(const ConflictExecutor&) = delete;
+
+        /*! \brief Destructor. Waits for all the jobs, ignoring their exceptions. */
+        ~ConflictExecutor()
+        {
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_idle.wait(lock, [this] { return m_active == 0; });
+            }
+            m_pool.reset();
+        }
+
+        /*! \brief Submits a job, run as soon as it is admitted.
+        *   \param object the object of the job
+        *   \param job the function to run
+        */
+        void submit(const value_type& object, job_type job)
+        {
+            std::vector<WorkStealingPool::task_type> started{};
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if (m_active == 0 && m_waiting == 0)
+                    label();
+                m_jobs[object].push_back(std::move(job));
+                ++m_waiting;
+                if (m_conflicts.cascading())
+                    m_waiting_by_component[component(object)].insert(object);
+                dispatch(object, started);
+            }
+            launch(started);
+        }
+
+        /*! \brief Waits until all the jobs submitted are run.
+        *   \exception the first exception thrown by a job since the previous call, the other jobs being run anyway
+        *   \exception std::runtime_error if no job is running and the waiting ones can't be admitted, such as with a capacity of 0
+        */
+        void wait()
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_idle.wait(lock, [this] { return m_active == 0; });
+            if (m_error)
+            {
+                auto error = m_error;
+                m_error = nullptr;
+                std::rethrow_exception(error);
+            }
+            if (m_waiting > 0)
+                throw std::runtime_error("Waiting jobs can't be admitted.");
+        }
+
+        /*! \brief Gets the number of jobs waiting for admission. */
+        size_t waiting() const
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_waiting;
+        }
+
+        /*! \brief Gets the number of jobs running. */
+        size_t running() const
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_active;
+        }
+
+    private:
+        using T = value_type;
+        using Hash = typename C::hasher;
+        using KeyEqual = typename C::key_equal;
+
+        static constexpr size_t npos = C::npos;
+
+        const C& m_conflicts;
+        capacities_type* m_capacities;
+        mutable std::mutex m_mutex{};
+        std::condition_variable m_idle{};
+        std::unordered_map<T, std::deque<job_type>, Hash, KeyEqual> m_jobs{};      // waiting jobs of each object
+        std::unordered_map<T, size_t, Hash, KeyEqual> m_running{};                 // running jobs of each object
+        // without cascading
+        std::unordered_map<T, size_t, Hash, KeyEqual> m_blocking{};                // running jobs of the objects in conflict with each object
+        std::unordered_map<T, std::vector<T>, Hash, KeyEqual> m_peers{};           // objects in conflict with each running object
+        // in cascading mode
+        std::unordered_map<T, size_t, Hash, KeyEqual> m_labels{};                  // component of each object in relationship
+        std::unordered_map<size_t, size_t> m_busy{};                               // running jobs of each component
+        std::unordered_map<size_t, std::unordered_set<T, Hash, KeyEqual>> m_waiting_by_component{};   // objects with waiting jobs
+        size_t m_waiting{ 0 };
+        size_t m_active{ 0 };
+        std::exception_ptr m_error{};
+        std::unique_ptr<WorkStealingPool> m_pool;
+
+        void label()
+        {
+            m_labels.clear();
+            if (m_conflicts.cascading())
+                m_labels = m_conflicts.component_labels();
+        }
+
+        size_t component(const T& object) const
+        {
+            auto itr = m_labels.find(object);
+            return itr == m_labels.end() ? npos : itr->second;
+        }
+
+        static size_t count(const std::unordered_map<T, size_t, Hash, KeyEqual>& counters, const T& object)
+        {
+            auto itr = counters.find(object);
+            return itr == counters.end() ? 0 : itr->second;
+        }
+
+        // decrements a counter, removed once null, and returns true if it became null
+        template <typename K, typename M>
+        static bool decrement(M& counters, const K& key)
+        {
+            auto itr = counters.find(key);
+            if (--itr->second > 0)
+                return false;
+            counters.erase(itr);
+            return true;
+        }
+
+        bool admissible(const T& object) const
+        {
+            if (count(m_running, object) > 0)
+                return false;
+            if (m_conflicts.cascading())
+            {
+                size_t label = component(object);
+                if (label != npos && m_busy.count(label) > 0)
+                    return false;
+            }
+            else if (count(m_blocking, object) > 0)
+                return false;
+            return m_capacities == nullptr || m_capacities->admissible(object);
+        }
+
+        // admits the oldest waiting job of an object if it is admissible, adding the task running it to the started ones
+        void dispatch(const T& object, std::vector<WorkStealingPool::task_type>& started)
+        {
+            auto itr = m_jobs.find(object);
+            if (itr == m_jobs.end() || !admissible(object))
+                return;
+            job_type job = std::move(itr->second.front());
+            itr->second.pop_front();
+            if (itr->second.empty())
+            {
+                m_jobs.erase(itr);
+                if (m_conflicts.cascading())
+                {
+                    auto waiting = m_waiting_by_component.find(component(object));
+                    waiting->second.erase(object);
+                    if (waiting->second.empty())
+                        m_waiting_by_component.erase(waiting);
+                }
+            }
+            --m_waiting;
+            ++m_active;
+            ++m_running[object];
+            if (m_conflicts.cascading())
+            {
+                size_t label = component(object);
+                if (label != npos)
+                    ++m_busy[label];
+            }
+            else
+            {
+                auto& peers = m_peers[object];
+                peers = m_conflicts.all_conflicts(object);
+                for (auto& con : peers)
+                    ++m_blocking[con];
+            }
+            if (m_capacities != nullptr)
+                m_capacities->acquire(object);
+            started.emplace_back([this, object, job = std::move(job)]
+                {
+                    std::exception_ptr error{};
+                    try
+                    {
+                        job();
+                    }
+                    catch (...)
+                    {
+                        error = std::current_exception();
+                    }
+                    finish(object, error);
+                });
+        }
+
+        // hands the tasks of the jobs admitted to the pool, their jobs being counted as active until they finish
+        void launch(std::vector<WorkStealingPool::task_type>& started)
+        {
+            for (auto& task : started)
+                m_pool->push(std::move(task));
+        }
+
+        void finish(const T& object, std::exception_ptr error)
+        {
+            std::vector<WorkStealingPool::task_type> started{};
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                release(object, error, started);
+            }
+            launch(started);
+        }
+
+        // releases the counters of a job that ended and admits the waiting jobs it was blocking, m_mutex being locked
+        void release(const T& object, std::exception_ptr error, std::vector<WorkStealingPool::task_type>& started)
+        {
+            if (error && !m_error)
+                m_error = error;
+            // the counters are released first, the next job of the object being then checked before the ones it was blocking
+            std::vector<T> candidates{ object };
+            decrement<T>(m_running, object);
+            if (m_conflicts.cascading())
+            {
+                size_t label = component(object);
+                if (label != npos && decrement<size_t>(m_busy, label))
+                {
+                    auto waiting = m_waiting_by_component.find(label);
+                    if (waiting != m_waiting_by_component.end())
+                        candidates.insert(candidates.end(), waiting->second.begin(), waiting->second.end());
+                }
+            }
+            else
+            {
+                auto peers = m_peers.find(object);
+                for (auto& con : peers->second)
+                    if (decrement<T>(m_blocking, con))
+                        candidates.push_back(con);
+                m_peers.erase(peers);
+            }
+            if (m_capacities != nullptr)
+            {
+                m_capacities->release(object);
+                for (auto id : m_capacities->constraints(object))
+                    for (auto& member : m_capacities->members(id))
+                        candidates.push_back(member);
+            }
+            for (auto& candidate : candidates)
+                dispatch(candidate, started);
+            if (--m_active == 0)
+                m_idle.notify_all();
+        }
+    };
+
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+/*! \file conflicts_filter.hpp
+*	\brief Implements the class BlockedBloomFilter used by the filtered storage engine.
+*   \author Christophe COUAILLET
+*/
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace Conflicts
+{
+
+    /*! \brief Mixes the bits of a hash value, so that weak hash functions such as the identity can feed a filter.
+    *   \param hash the value to mix
+    *   \return the mixed value (splitmix64 finalizer)
+    */
+    inline uint64_t mix_hash(uint64_t hash) noexcept
+    {
+        hash ^= hash >> 30;
+        hash *= 0xBF58476D1CE4E5B9ull;
+        hash ^= hash >> 27;
+        hash *= 0x94D049BB133111EBull;
+        hash ^= hash >> 31;
+        return hash;
+    }
+
+    /*! \brief Class BlockedBloomFilter implements a Bloom filter whose probes for a key all fall in a single cache line.
+    *
+        A negative answer is certain, a positive one may be wrong. Keys are hash values that must already be well mixed.
+        Keys cannot be removed: the owner must rebuild the filter when too many inserted keys became obsolete.
+    */
+    class BlockedBloomFilter
+    {
+    public:
+        /*! \brief Constructor.
+        *   \param capacity the number of keys the filter is sized for
+        */
+        explicit BlockedBloomFilter(size_t capacity = 0) { resize(capacity); }
+
+        /*! \brief Clears the filter and sizes it for the given number of keys.
+        *   \param capacity the number of keys the filter is sized for
+        */
+        void resize(size_t capacity)
+        {
+            size_t blocks{ 1 };
+            while (blocks * BlockBits < capacity * BitsPerKey)
+                blocks <<= 1;
+            m_blocks.assign(blocks, Block{});
+            m_capacity = blocks * BlockBits / BitsPerKey;
+        }
+
+        /*! \brief Gets the number of keys the filter is sized for. Beyond it, the false positive rate increases. */
+        size_t capacity() const noexcept { return m_capacity; }
+
+        /*! \brief Removes all keys. */
+        void clear() noexcept { std::fill(m_blocks.begin(), m_blocks.end(), Block{}); }
+
+        /*! \brief Inserts a key.
+        *   \param hash the key to insert
+        */
+        void insert(uint64_t hash) noexcept
+        {
+            Block& block = m_blocks[block_of(hash)];
+            for (unsigned i = 0; i < Probes; ++i)
+            {
+                unsigned bit = probe(hash, i);
+                block.words[bit >> 6] |= uint64_t{ 1 } << (bit & 63);
+            }
+        }
+
+        /*! \brief Checks if a key may have been inserted.
+        *   \param hash the key to check
+        *   \return false if the key has certainly not been inserted
+        */
+        bool may_contain(uint64_t hash) const noexcept
+        {
+            const Block& block = m_blocks[block_of(hash)];
+            for (unsigned i = 0; i < Probes; ++i)
+            {
+                unsigned bit = probe(hash, i);
+                if ((block.words[bit >> 6] & (uint64_t{ 1 } << (bit & 63))) == 0)
+                    return false;
+            }
+            return true;
+        }
+
+    private:
+        static constexpr size_t BlockBits = 512;            // one cache line
+        static constexpr size_t BitsPerKey = 12;
+        static constexpr unsigned Probes = 6;
+
+        struct alignas(64) Block
+        {
+            uint64_t words[BlockBits / 64]{};
+        };
+
+        std::vector<Block> m_blocks{};
+        size_t m_capacity{ 0 };
+
+        // the high half of the key selects the block, the low half the bits inside the block
+        size_t block_of(uint64_t hash) const noexcept { return static_cast<size_t>(hash >> 32) & (m_blocks.size() - 1); }
+
+        static unsigned probe(uint64_t hash, unsigned i) noexcept
+        {
+            uint32_t h1 = static_cast<uint32_t>(hash) & 0xFFFF;
+            uint32_t h2 = (static_cast<uint32_t>(hash) >> 16) | 1;
+            return static_cast<unsigned>((h1 + i * h2) & (BlockBits - 1));
+        }
+    };
+
+}
@@ -0,0 +1,956 @@
+#pragma once
+
+/*! \file conflicts_frozen.hpp
+*	\brief Implements the template class FrozenConflicts, an immutable snapshot of a Conflicts instance.
+*   \author Christophe COUAILLET
+*/
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <unordered_map>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "conflicts.hpp"
+#include "conflicts_engines.hpp"
+#include "conflicts_pages.hpp"
+#include "conflicts_simd.hpp"
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <xmmintrin.h>
+#endif
+
+namespace Conflicts
+{
+
+    /*! \brief Hints the processor to load the cache line of an address, without waiting for it.
+    *   \param address the address to load, that may be invalid
+    */
+    inline void prefetch(const void* address) noexcept
+    {
+#if defined(__GNUC__) || defined(__clang__)
+        __builtin_prefetch(address);
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+        _mm_prefetch(static_cast<const char*>(address), _MM_HINT_T0);
+#else
+        (void)address;
+#endif
+    }
+
+    /*! \brief Numbering of the objects of a frozen snapshot. */
+    enum class Ordering
+    {
+        None,                   //!< objects are numbered in the iteration order of the storage
+        BreadthFirst,           //!< components are numbered one after the other, each one in breadth first order
+        ReverseCuthillMcKee     //!< as BreadthFirst, visiting the neighbours by increasing degree, then reversed to narrow the bandwidth
+    };
+
+    /*! \brief Contiguous range of object identifiers of a frozen snapshot. */
+    template <typename Id>
+    struct IdRange
+    {
+        const Id* first;
+        const Id* last;
+
+        const Id* begin() const noexcept { return first; }
+        const Id* end() const noexcept { return last; }
+        size_t size() const noexcept { return static_cast<size_t>(last - first); }
+        bool empty() const noexcept { return first == last; }
+        Id operator[](size_t pos) const noexcept { return first[pos]; }
+    };
+
+    /*! \brief Pair of objects whose conflict profiles are similar, see FrozenConflicts::similar_pairs(). */
+    template <typename T>
+    struct SimilarPair
+    {
+        T object1;
+        T object2;
+        double similarity;      //!< Jaccard index of the direct conflicts of both objects
+    };
+
+    /*! \brief Class FrozenConflicts is an immutable snapshot of the conflict relationships, stored in compressed sparse rows.
+    *
+        Each object involved in a relationship is interned to a dense identifier. The identifiers of the objects in direct relationship with
+        an object are stored contiguously and sorted, as are the members of each connected component.
+        When the storage keeps weights, the weights are stored alongside the identifiers, and the neighbours are also listed by
+        decreasing weight so that the scans of a minimum weight stop at the first lighter relationship.
+        The numbering set by the Ordering places neighbours and component members close to each other, improving the cache and TLB
+        hit rates of the traversals and batch queries. The identifier arrays can be backed by huge pages, see Pages.
+    */
+    template <typename T, typename Hash = std::hash<T>, typename KeyEqual = std::equal_to<T>>
+    class FrozenConflicts
+    {
+    public:
+        using id_type = uint32_t;
+        using range_type = IdRange<id_type>;
+        template <typename U>
+        using array_type = std::vector<U, PageAllocator<U>>;
+
+        /*! \brief Identifier of the objects not involved in any relationship. */
+        static constexpr id_type npos = std::numeric_limits<id_type>::max();
+
+        /*! \brief Default constructor. The snapshot is empty. */
+        FrozenConflicts() = default;
+
+        /*! \brief Constructor from the storage of a Conflicts instance.
+        *   \param storage the storage to take the snapshot of
+        *   \param cascading the cascading mode of the snapshot
+        *   \param ordering the numbering of the objects
+        *   \param pages the kind of pages backing the identifier arrays
+        *   \sa Conflicts::freeze()
+        */
+        template <typename Storage>
+        FrozenConflicts(const Storage& storage, bool cascading, Ordering ordering = Ordering::ReverseCuthillMcKee, Pages pages = Pages::Default)
+            : FrozenConflicts(storage, Depth{ cascading ? Depth::unbounded : 1 }, ordering, pages) {}
+
+        /*! \brief Constructor from the storage of a Conflicts instance, with a bounded depth.
+        *   \param storage the storage to take the snapshot of
+        *   \param depth the maximum number of relationships between objects in conflict
+        *   \param ordering the numbering of the objects
+        *   \param pages the kind of pages backing the identifier arrays
+        */
+        template <typename Storage>
+        FrozenConflicts(const Storage& storage, Depth depth, Ordering ordering = Ordering::ReverseCuthillMcKee, Pages pages = Pages::Default);
+
+        /*! \brief Gets the kind of pages backing the identifier arrays. */
+        Pages pages() const noexcept { return m_neighbours.get_allocator().pages(); }
+
+        /*! \brief Informs on the cascading mode of the snapshot */
+        bool cascading() const noexcept { return m_cascading; }
+
+        /*! \brief Gets the maximum number of relationships between objects in conflict, Depth::unbounded in cascading mode. */
+        size_t depth() const noexcept { return m_depth; }
+
+        /*! \brief Checks if any relationship exists. */
+        bool empty() const noexcept { return m_neighbours.empty(); }
+
+        /*! \brief Gets the number of relationships. */
+        size_t size() const noexcept { return m_neighbours.size() / 2; }
+
+        /*! \brief Gets the number of objects involved in relationships, the identifiers being in [0, objects()). */
+        size_t objects() const noexcept { return m_objects.size(); }
+
+        /*! \brief Gets the identifier of an object.
+        *   \return the identifier, or npos if the object is not involved in any relationship
+        */
+        id_type id(const T& object) const noexcept
+        {
+            auto itr = m_ids.find(object);
+            return itr == m_ids.end() ? npos : itr->second;
+        }
+
+        /*! \brief Gets the object of an identifier. */
+        const T& object(id_type id) const noexcept { return m_objects[id]; }
+
+        /*! \brief Gets the sorted identifiers of the objects in direct relationship with an object. */
+        range_type neighbours(id_type id) const noexcept { return { m_neighbours.data() + m_offsets[id], m_neighbours.data() + m_offsets[id + 1] }; }
+
+        /*! \brief Gets the label of the connected component of an object, labels being in [0, components()). */
+        id_type component(id_type id) const noexcept { return m_labels[id]; }
+
+        /*! \brief Gets the number of connected components. */
+        size_t components() const noexcept { return m_component_offsets.empty() ? 0 : m_component_offsets.size() - 1; }
+
+        /*! \brief Gets the sorted identifiers of the members of a connected component. */
+        range_type members(id_type label) const noexcept
+        {
+            return { m_members.data() + m_component_offsets[label], m_members.data() + m_component_offsets[label + 1] };
+        }
+
+        bool in_conflict(const T& object) const noexcept { return id(object) != npos; }
+        bool in_conflict(const T& object1, const T& object2) const noexcept;
+        bool in_conflict_id(id_type id1, id_type id2) const noexcept;
+        std::vector<T> conflicts(const T& object) const;
+        std::vector<T> conflicts(const T& object, Weight min_weight) const;
+        bool in_conflict(const T& object1, const T& object2, Weight min_weight) const;
+        Weight weight_id(id_type id1, id_type id2) const;
+        Weight weight(const T& object1, const T& object2) const { return weight_id(id(object1), id(object2)); }
+        std::vector<T> all_conflicts(const T& object) const;
+        std::vector<T> conflicts_within(const T& object, size_t hops) const;
+
+        std::vector<T> common_conflicts(const T& object1, const T& object2) const;
+        bool shares_conflict(const T& object1, const T& object2) const noexcept;
+        double similarity_id(id_type id1, id_type id2) const noexcept;
+        double conflict_similarity(const T& object1, const T& object2) const noexcept;
+        std::vector<SimilarPair<T>> similar_pairs(double threshold) const;
+
+        /*! \brief Gets the number of 64 bits words of a bitset over the identifiers. */
+        size_t mask_words() const noexcept { return (m_objects.size() + 63) / 64; }
+
+        void compatible_with(const id_type* set, size_t count, uint64_t* candidates) const;
+        std::vector<T> compatible_with(const std::vector<T>& set, const std::vector<T>& candidates) const;
+
+        void in_conflict(const std::pair<id_type, id_type>* queries, size_t count, bool* results) const noexcept;
+        std::vector<bool> in_conflict(const std::vector<std::pair<T, T>>& queries) const;
+        std::vector<std::vector<T>> all_conflicts(const std::vector<T>& objects) const;
+
+        /*! \brief Number of queries of a batch whose memory accesses are overlapped. */
+        static constexpr size_t BatchGroup = 16;
+
+    private:
+        bool m_cascading{ false };
+        size_t m_depth{ 1 };
+        std::vector<T> m_objects{};
+        std::unordered_map<T, id_type, Hash, KeyEqual> m_ids{};
+        array_type<size_t> m_offsets{ 0 };
+        array_type<id_type> m_neighbours{};
+        array_type<id_type> m_labels{};
+        array_type<size_t> m_component_offsets{};
+        array_type<id_type> m_members{};
+        array_type<Weight> m_weights{};         // weights of the relationships in m_neighbours, empty if the storage has none
+        array_type<id_type> m_heavy{};          // neighbours by decreasing weight, empty if the storage has no weights
+        array_type<Weight> m_heavy_weights{};
+
+        static constexpr Weight any_weight = std::numeric_limits<Weight>::lowest();
+
+        bool bounded() const noexcept { return !m_cascading && m_depth > 1; }
+
+        template <typename F>
+        bool for_each_heavy(id_type id, Weight min_weight, F&& f) const;
+        template <typename F>
+        bool bounded_search(id_type id, size_t hops, F&& f, Weight min_weight = any_weight) const;
+
+        // visit marks of the bounded searches, kept per thread and reused: each search takes a new mark value
+        struct Marks
+        {
+            std::vector<uint32_t> values{};
+            uint32_t current{ 0 };
+        };
+        static Marks& marks(size_t count);
+
+        void build(const std::vector<std::pair<id_type, id_type>>& pairs, const std::vector<Weight>& weights);
+        std::vector<id_type> order(Ordering ordering) const;
+        void label();
+    };
+
+    // Implementation of templates functions
+
+    template <typename T, typename Hash, typename KeyEqual>
+    template <typename Storage>
+    FrozenConflicts<T, Hash, KeyEqual>::FrozenConflicts(const Storage& storage, Depth depth, Ordering ordering, Pages pages)
+        : m_cascading(depth.hops == Depth::unbounded), m_depth(std::max<size_t>(depth.hops, 1)), m_offsets(1, size_t{ 0 }, pages), m_neighbours(pages), m_labels(pages), m_component_offsets(pages), m_members(pages),
+        m_weights(pages), m_heavy(pages), m_heavy_weights(pages)
+    {
+        // objects are first interned in the iteration order of the storage
+        std::vector<std::pair<id_type, id_type>> pairs{};
+        std::vector<Weight> weights{};
+        pairs.reserve(storage.size());
+        auto intern = [this](const T& object)
+            {
+                auto [itr, inserted] = m_ids.emplace(object, static_cast<id_type>(m_objects.size()));
+                if (inserted)
+                {
+                    assert(m_objects.size() < npos && "Too many objects.");
+                    m_objects.push_back(object);
+                }
+                return itr->second;
+            };
+        storage.for_each_pair([&](const T& object1, const T& object2)
+            {
+                pairs.emplace_back(intern(object1), intern(object2));
+                if constexpr (is_weighted_v<Storage, T>)
+                    weights.push_back(storage.weight(object1, object2));
+                return true;
+            });
+        build(pairs, weights);
+        if (ordering != Ordering::None)
+        {
+            // renumbering: rank[former id] = new id
+            auto sequence = order(ordering);
+            std::vector<id_type> rank(sequence.size());
+            std::vector<T> objects{};
+            objects.reserve(sequence.size());
+            for (size_t pos = 0; pos < sequence.size(); ++pos)
+            {
+                rank[sequence[pos]] = static_cast<id_type>(pos);
+                objects.push_back(std::move(m_objects[sequence[pos]]));
+            }
+            m_objects = std::move(objects);
+            for (auto& item : m_ids)
+                item.second = rank[item.second];
+            for (auto& pair : pairs)
+                pair = { rank[pair.first], rank[pair.second] };
+            build(pairs, weights);
+        }
+        label();
+    }
+
+    // fills the compressed sparse rows from the pairs of identifiers and their weights, if any
+    template <typename T, typename Hash, typename KeyEqual>
+    void FrozenConflicts<T, Hash, KeyEqual>::build(const std::vector<std::pair<id_type, id_type>>& pairs, const std::vector<Weight>& weights)
+    {
+        m_offsets.assign(m_objects.size() + 1, 0);
+        for (auto& pair : pairs)
+        {
+            ++m_offsets[pair.first + 1];
+            ++m_offsets[pair.second + 1];
+        }
+        for (size_t id = 0; id < m_objects.size(); ++id)
+            m_offsets[id + 1] += m_offsets[id];
+        m_neighbours.resize(pairs.size() * 2);
+        std::vector<size_t> fill(m_offsets.begin(), m_offsets.end() - 1);
+        for (auto& pair : pairs)
+        {
+            m_neighbours[fill[pair.first]++] = pair.second;
+            m_neighbours[fill[pair.second]++] = pair.first;
+        }
+        if (weights.empty())
+        {
+            m_weights.clear();
+            m_heavy.clear();
+            m_heavy_weights.clear();
+            for (size_t id = 0; id < m_objects.size(); ++id)
+                std::sort(m_neighbours.begin() + m_offsets[id], m_neighbours.begin() + m_offsets[id + 1]);
+            return;
+        }
+        // the weights follow their identifiers, first by identifier then by decreasing weight
+        m_weights.resize(m_neighbours.size());
+        m_heavy.resize(m_neighbours.size());
+        m_heavy_weights.resize(m_neighbours.size());
+        fill.assign(m_offsets.begin(), m_offsets.end() - 1);
+        for (size_t pos = 0; pos < pairs.size(); ++pos)
+        {
+            m_weights[fill[pairs[pos].first]++] = weights[pos];
+            m_weights[fill[pairs[pos].second]++] = weights[pos];
+        }
+        std::vector<std::pair<id_type, Weight>> row{};
+        for (size_t id = 0; id < m_objects.size(); ++id)
+        {
+            size_t first = m_offsets[id], last = m_offsets[id + 1];
+            row.clear();
+            for (size_t pos = first; pos < last; ++pos)
+                row.emplace_back(m_neighbours[pos], m_weights[pos]);
+            std::sort(row.begin(), row.end());
+            for (size_t pos = first; pos < last; ++pos)
+                std::tie(m_neighbours[pos], m_weights[pos]) = row[pos - first];
+            std::stable_sort(row.begin(), row.end(), [](const std::pair<id_type, Weight>& item1, const std::pair<id_type, Weight>& item2) { return item1.second > item2.second; });
+            for (size_t pos = first; pos < last; ++pos)
+                std::tie(m_heavy[pos], m_heavy_weights[pos]) = row[pos - first];
+        }
+    }
+
+    // gives the former identifiers in their new order
+    template <typename T, typename Hash, typename KeyEqual>
+    std::vector<typename FrozenConflicts<T, Hash, KeyEqual>::id_type> FrozenConflicts<T, Hash, KeyEqual>::order(Ordering ordering) const
+    {
+        size_t count = m_objects.size();
+        auto degree = [this](id_type id) { return m_offsets[id + 1] - m_offsets[id]; };
+        std::vector<id_type> sequence{};
+        sequence.reserve(count);
+        std::vector<bool> visited(count, false);
+        // roots are taken by increasing degree, a low degree object being likely at the periphery of its component
+        std::vector<id_type> roots(count);
+        for (size_t id = 0; id < count; ++id)
+            roots[id] = static_cast<id_type>(id);
+        std::stable_sort(roots.begin(), roots.end(), [&degree](id_type id1, id_type id2) { return degree(id1) < degree(id2); });
+        std::vector<id_type> level{};
+        for (id_type root : roots)
+        {
+            if (visited[root])
+                continue;
+            visited[root] = true;
+            size_t head = sequence.size();
+            sequence.push_back(root);
+            while (head < sequence.size())
+            {
+                id_type current = sequence[head++];
+                level.clear();
+                for (id_type con : neighbours(current))
+                    if (!visited[con])
+                    {
+                        visited[con] = true;
+                        level.push_back(con);
+                    }
+                if (ordering == Ordering::ReverseCuthillMcKee)
+                    std::stable_sort(level.begin(), level.end(), [&degree](id_type id1, id_type id2) { return degree(id1) < degree(id2); });
+                sequence.insert(sequence.end(), level.begin(), level.end());
+            }
+        }
+        if (ordering == Ordering::ReverseCuthillMcKee)
+            std::reverse(sequence.begin(), sequence.end());
+        return sequence;
+    }
+
+    // labels the connected components and lists their members
+    template <typename T, typename Hash, typename KeyEqual>
+    void FrozenConflicts<T, Hash, KeyEqual>::label()
+    {
+        size_t count = m_objects.size();
+        m_labels.assign(count, npos);
+        m_members.clear();
+        m_members.reserve(count);
+        m_component_offsets.assign(1, 0);
+        for (size_t root = 0; root < count; ++root)
+        {
+            if (m_labels[root] != npos)
+                continue;
+            id_type label = static_cast<id_type>(m_component_offsets.size() - 1);
+            size_t head = m_members.size();
+            m_labels[root] = label;
+            m_members.push_back(static_cast<id_type>(root));
+            while (head < m_members.size())
+                for (id_type con : neighbours(m_members[head++]))
+                    if (m_labels[con] == npos)
+                    {
+                        m_labels[con] = label;
+                        m_members.push_back(con);
+                    }
+            std::sort(m_members.begin() + m_component_offsets.back(), m_members.end());
+            m_component_offsets.push_back(m_members.size());
+        }
+    }
+
+    // takes a new mark value, the marks being cleared once all the values have been used
+    template <typename T, typename Hash, typename KeyEqual>
+    typename FrozenConflicts<T, Hash, KeyEqual>::Marks& FrozenConflicts<T, Hash, KeyEqual>::marks(size_t count)
+    {
+        thread_local Marks result{};
+        if (result.values.size() < count)
+            result.values.resize(count, 0);
+        if (++result.current == 0)
+        {
+            std::fill(result.values.begin(), result.values.end(), 0);
+            result.current = 1;
+        }
+        return result;
+    }
+
+    // calls f for each object in direct relationship of at least min_weight until it returns false, stopping at the first lighter one
+    template <typename T, typename Hash, typename KeyEqual>
+    template <typename F>
+    bool FrozenConflicts<T, Hash, KeyEqual>::for_each_heavy(id_type id, Weight min_weight, F&& f) const
+    {
+        if (m_heavy.empty() || min_weight == any_weight)
+        {
+            if (min_weight > DefaultWeight)
+                return true;
+            for (id_type con : neighbours(id))
+                if (!f(con))
+                    return false;
+            return true;
+        }
+        for (size_t pos = m_offsets[id]; pos < m_offsets[id + 1] && m_heavy_weights[pos] >= min_weight; ++pos)
+            if (!f(m_heavy[pos]))
+                return false;
+        return true;
+    }
+
+    // Breadth first search of the objects within hops relationships of at least min_weight,
+    // calling f for each one by increasing distance until it returns false.
+    template <typename T, typename Hash, typename KeyEqual>
+    template <typename F>
+    bool FrozenConflicts<T, Hash, KeyEqual>::bounded_search(id_type id, size_t hops, F&& f, Weight min_weight) const
+    {
+        auto& visits = marks(m_objects.size());
+        uint32_t mark = visits.current;
+        visits.values[id] = mark;
+        std::vector<id_type> frontier{ id }, next{};
+        for (size_t hop = 0; hop < hops && !frontier.empty(); ++hop)
+        {
+            next.clear();
+            for (id_type current : frontier)
+            {
+                bool stopped = !for_each_heavy(current, min_weight, [&](id_type con)
+                    {
+                        if (visits.values[con] == mark)
+                            return true;
+                        visits.values[con] = mark;
+                        next.push_back(con);
+                        return f(con);
+                    });
+                if (stopped)
+                    return false;
+            }
+            frontier.swap(next);
+        }
+        return true;
+    }
+
+    /*! \brief Checks if a conflict exists between 2 objects, given by their identifiers.
+    *   \return true if the 2 objects are in direct relationship, belong to the same component in cascading mode,
+    *   or are linked by a path within the depth otherwise
+    */
+    template <typename T, typename Hash, typename KeyEqual>
+    bool FrozenConflicts<T, Hash, KeyEqual>::in_conflict_id(id_type id1, id_type id2) const noexcept
+    {
+        if (id1 == npos || id2 == npos)
+            return false;
+        if (m_cascading)
+            return m_labels[id1] == m_labels[id2];
+        // the shortest list is searched
+        if (m_offsets[id1 + 1] - m_offsets[id1] > m_offsets[id2 + 1] - m_offsets[id2])
+            std::swap(id1, id2);
+        if (bounded())
+            return id1 != id2 && !bounded_search(id1, m_depth, [id2](id_type con) { return con != id2; });
+        auto range = neighbours(id1);
+        return std::binary_search(range.begin(), range.end(), id2);
+    }
+
+    /*! \brief Checks if a conflict exists between 2 objects.
+    *   \return true if the 2 objects are in direct relationship, or belong to the same component in cascading mode
+    */
+    template <typename T, typename Hash, typename KeyEqual>
+    bool FrozenConflicts<T, Hash, KeyEqual>::in_conflict(const T& object1, const T& object2) const noexcept
+    {
+        return in_conflict_id(id(object1), id(object2));
+    }
+
+    /*! \brief Lists the objects in direct relationship with the given object. */
+    template <typename T, typename Hash, typename KeyEqual>
+    std::vector<T> FrozenConflicts<T, Hash, KeyEqual>::conflicts(const T& object) const
+    {
+        std::vector<T> result{};
+        id_type current = id(object);
+        if (current != npos)
+            for (id_type con : neighbours(current))
+                result.push_back(m_objects[con]);
+        return result;
+    }
+
+    /*! \brief Lists the objects in direct relationship of a minimum weight with the given object, by decreasing weight.
+    *
+    *   The scan stops at the first lighter relationship. The relationships of a snapshot without weights have DefaultWeight.
+    */
+    template <typename T, typename Hash, typename KeyEqual>
+    std::vector<T> FrozenConflicts<T, Hash, KeyEqual>::conflicts(const T& object, Weight min_weight) const
+    {
+        std::vector<T> result{};
+        id_type current = id(object);
+        if (current != npos)
+            for_each_heavy(current, min_weight, [this, &result](id_type con) { result.push_back(m_objects[con]); return true; });
+        return result;
+    }
+
+    /*! \brief Checks if a conflict exists between 2 objects, only following the relationships of a minimum weight.
+    *   \return true if the 2 objects are linked by relationships of at least min_weight, within the depth of the snapshot
+    */
+    template <typename T, typename Hash, typename KeyEqual>
+    bool FrozenConflicts<T, Hash, KeyEqual>::in_conflict(const T& object1, const T& object2, Weight min_weight) const
+    {
+        id_type id1 = id(object1), id2 = id(object2);
+        if (id1 == npos || id2 == npos)
+            return false;
+        if (id1 == id2)
+            return m_cascading && !for_each_heavy(id1, min_weight, [](id_type) { return false; });
+        // the relationships are searched from the object with the lowest degree
+        if (m_offsets[id1 + 1] - m_offsets[id1] > m_offsets[id2 + 1] - m_offsets[id2])
+            std::swap(id1, id2);
+        if (!m_cascading && m_depth == 1)
+        {
+            auto range = neighbours(id1);
+            auto itr = std::lower_bound(range.begin(), range.end(), id2);
+            if (itr == range.end() || *itr != id2)
+                return false;
+            return (m_weights.empty() ? DefaultWeight : m_weights[static_cast<size_t>(itr - m_neighbours.data())]) >= min_weight;
+        }
+        return !bounded_search(id1, m_depth, [id2](id_type con) { return con != id2; }, min_weight);
+    }
+
+    /*! \brief Gets the weight of a direct relationship, given by the identifiers of its objects.
+    *   \return the weight, DefaultWeight if the snapshot has no weights
+    *   \exception std::out_of_range if an identifier is unknown or the objects are not in direct relationship
+    */
+    template <typename T, typename Hash, typename KeyEqual>
+    Weight FrozenConflicts<T, Hash, KeyEqual>::weight_id(id_type id1, id_type id2) const
+    {
+        if (id1 >= m_objects.size() || id2 >= m_objects.size())
+            throw std::out_of_range("Object is not involved in any relationship.");
+        auto range = neighbours(id1);
+        auto itr = std::lower_bound(range.begin(), range.end(), id2);
+        if (itr == range.end() || *itr != id2)
+            throw std::out_of_range("Relationship does not exist.");
+        return m_weights.empty() ? DefaultWeight : m_weights[static_cast<size_t>(itr - m_neighbours.data())];
+    }
+
+    /*! \brief Lists the objects in conflict with the given object, all the other members of its component in cascading mode,
+    *   the objects within the depth otherwise.
+    */
+    template <typename T, typename Hash, typename KeyEqual>
+    std::vector<T> FrozenConflicts<T, Hash, KeyEqual>::all_conflicts(const T& object) const
+    {
+        if (bounded())
+            return conflicts_within(object, m_depth);
+        if (!m_cascading)
+            return conflicts(object);
+        std::vector<T> result{};
+        id_type current = id(object);
+        if (current != npos)
+            for (id_type member : members(m_labels[current]))
+                if (member != current)
+                    result.push_back(m_objects[member]);
+        return result;
+    }
+
+    /*! \brief Lists the objects linked to the given object by a path of at most hops relationships, whatever the depth of the snapshot.
+    *   \param object the object whose neighbourhood is searched
+    *   \param hops the maximum number of relationships
+    *   \return the objects by increasing distance, the given one excluded
+    */
+    template <typename T, typename Hash, typename KeyEqual>
+    std::vector<T> FrozenConflicts<T, Hash, KeyEqual>::conflicts_within(const T& object, size_t hops) const
+    {
+        std::vector<T> result{};
+        id_type current = id(object);
+        if (current != npos)
+            bounded_search(current, hops, [this, &result](id_type con) { result.push_back(m_objects[con]); return true; });
+        return result;
+    }
+
+    /*! \brief Checks a batch of conflicts between objects given by their identifiers.
+    *   \param queries the pairs of identifiers to check, npos being allowed
+    *   \param count the number of pairs
+    *   \param results receives the result of each pair
+    *
+    *   The queries are processed by groups of BatchGroup: each stage prefetches, for the whole group, the memory read by the next stage,
+    *   so that the cache misses of the group overlap instead of being waited for one after the other.
+    *   With a bounded depth, each query is a search and is processed on its own.
+    */
+    template <typename T, typename Hash, typename KeyEqual>
+    void FrozenConflicts<T, Hash, KeyEqual>::in_conflict(const std::pair<id_type, id_type>* queries, size_t count, bool* results) const noexcept
+    {
+        if (bounded())
+        {
+            for (size_t i = 0; i < count; ++i)
+                results[i] = in_conflict_id(queries[i].first, queries[i].second);
+            return;
+        }
+        const id_type* table = m_cascading ? m_labels.data() : nullptr;
+        for (size_t base = 0; base < count; base += BatchGroup)
+        {
+            size_t end = std::min(count, base + BatchGroup);
+            // stage 1: labels or offsets of both objects
+            for (size_t i = base; i < end; ++i)
+            {
+                auto [id1, id2] = queries[i];
+                if (id1 == npos || id2 == npos)
+                    continue;
+                if (table)
+                {
+                    prefetch(table + id1);
+                    prefetch(table + id2);
+                }
+                else
+                {
+                    prefetch(m_offsets.data() + id1);
+                    prefetch(m_offsets.data() + id2);
+                }
+            }
+            if (table)
+            {
+                for (size_t i = base; i < end; ++i)
+                    results[i] = in_conflict_id(queries[i].first, queries[i].second);
+                continue;
+            }
+            // stage 2: the shortest list of neighbours is selected, its first and middle lines are prefetched
+            const id_type* first[BatchGroup];
+            const id_type* last[BatchGroup];
+            id_type target[BatchGroup];
+            for (size_t i = base; i < end; ++i)
+            {
+                size_t pos = i - base;
+                auto [id1, id2] = queries[i];
+                first[pos] = last[pos] = nullptr;
+                target[pos] = npos;
+                if (id1 == npos || id2 == npos)
+                    continue;
+                if (m_offsets[id1 + 1] - m_offsets[id1] > m_offsets[id2 + 1] - m_offsets[id2])
+                    std::swap(id1, id2);
+                first[pos] = m_neighbours.data() + m_offsets[id1];
+                last[pos] = m_neighbours.data() + m_offsets[id1 + 1];
+                target[pos] = id2;
+                prefetch(first[pos]);
+                prefetch(first[pos] + (last[pos] - first[pos]) / 2);
+            }
+            // stage 3: search
+            for (size_t i = base; i < end; ++i)
+            {
+                size_t pos = i - base;
+                results[i] = target[pos] != npos && std::binary_search(first[pos], last[pos], target[pos]);
+            }
+        }
+    }
+
+    /*! \brief Checks a batch of conflicts between objects.
+    *   \param queries the pairs of objects to check
+    *   \return the result of each pair
+    *
+    *   Only the checks are pipelined: the identifiers are looked up one after the other beforehand, as the buckets of the unordered_map
+    *   can't be prefetched. The identifiers should be kept by id() when the same objects are queried again.
+    *   \sa FrozenConflicts::in_conflict(const std::pair<id_type, id_type>*, size_t, bool*)
+    */
+    template <typename T, typename Hash, typename KeyEqual>
+    std::vector<bool> FrozenConflicts<T, Hash, KeyEqual>::in_conflict(const std::vector<std::pair<T, T>>& queries) const
+    {
+        std::vector<std::pair<id_type, id_type>> ids{};
+        ids.reserve(queries.size());
+        for (auto& query : queries)
+            ids.emplace_back(id(query.first), id(query.second));
+        std::unique_ptr<bool[]> results(new bool[queries.size()]);
+        in_conflict(ids.data(), ids.size(), results.get());
+        return std::vector<bool>(results.get(), results.get() + queries.size());
+    }
+
+    /*! \brief Lists the objects in conflict with each object of a batch.
+    *   \param objects the objects to check
+    *   \return the list of the objects in conflict with each object, as by all_conflicts(const T&)
+    *
+    *   The memory accesses of the objects are overlapped by groups of BatchGroup, except the lookups of their identifiers which are
+    *   made one after the other, the buckets of the unordered_map can't be prefetched.
+    */
+    template <typename T, typename Hash, typename KeyEqual>
+    std::vector<std::vector<T>> FrozenConflicts<T, Hash, KeyEqual>::all_conflicts(const std::vector<T>& objects) const
+    {
+        std::vector<std::vector<T>> result(objects.size());
+        if (bounded())
+        {
+            for (size_t i = 0; i < objects.size(); ++i)
+                result[i] = all_conflicts(objects[i]);
+            return result;
+        }
+        id_type ids[BatchGroup];
+        range_type ranges[BatchGroup];
+        for (size_t base = 0; base < objects.size(); base += BatchGroup)
+        {
+            size_t end = std::min(objects.size(), base + BatchGroup);
+            // stage 1: label of the component or offsets of the neighbours
+            for (size_t i = base; i < end; ++i)
+            {
+                id_type current = ids[i - base] = id(objects[i]);
+                if (current != npos)
+                    prefetch(m_cascading ? static_cast<const void*>(m_labels.data() + current) : static_cast<const void*>(m_offsets.data() + current));
+            }
+            // stage 2: the list of identifiers
+            for (size_t i = base; i < end; ++i)
+            {
+                size_t pos = i - base;
+                ranges[pos] = { nullptr, nullptr };
+                if (ids[pos] == npos)
+                    continue;
+                ranges[pos] = m_cascading ? members(m_labels[ids[pos]]) : neighbours(ids[pos]);
+                prefetch(ranges[pos].first);
+            }
+            // stage 3: the objects
+            for (size_t i = base; i < end; ++i)
+            {
+                size_t pos = i - base;
+                result[i].reserve(ranges[pos].size());
+                for (id_type con : ranges[pos])
+                    if (con != ids[pos])
+                        result[i].push_back(m_objects[con]);
+            }
+        }
+        return result;
+    }
+
+    /*! \brief Lists the objects in direct relationship with both given objects.
+    *   \param object1,object2 the objects whose conflicts are intersected
+    *   \return the common conflicts, in the order of the identifiers
+    *
+    *   The sorted lists of neighbours are intersected by the kernel selected for the processor, see Simd::intersect().
+    */
+    template <typename T, typename Hash, typename KeyEqual>
+    std::vector<T> FrozenConflicts<T, Hash, KeyEqual>::common_conflicts(const T& object1, const T& object2) const
+    {
+        std::vector<T> result{};
+        id_type id1 = id(object1), id2 = id(object2);
+        if (id1 == npos || id2 == npos)
+            return result;
+        auto range1 = neighbours(id1), range2 = neighbours(id2);
+        std::vector<id_type> common(std::min(range1.size(), range2.size()));
+        common.resize(Simd::intersect(range1.first, range1.size(), range2.first, range2.size(), common.data()));
+        result.reserve(common.size());
+        for (id_type con : common)
+            result.push_back(m_objects[con]);
+        return result;
+    }
+
+    /*! \brief Checks if an object is in direct relationship with both given objects.
+    *   \param object1,object2 the objects whose conflicts are intersected
+    *   \return true if the objects have a common conflict
+    */
+    template <typename T, typename Hash, typename KeyEqual>
+    bool FrozenConflicts<T, Hash, KeyEqual>::shares_conflict(const T& object1, const T& object2) const noexcept
+    {
+        id_type id1 = id(object1), id2 = id(object2);
+        if (id1 == npos || id2 == npos)
+            return false;
+        auto range1 = neighbours(id1), range2 = neighbours(id2);
+        return Simd::intersects(range1.first, range1.size(), range2.first, range2.size());
+    }
+
+    /*! \brief Computes the Jaccard index of the direct conflicts of 2 objects, given by their identifiers.
+    *   \return the number of common conflicts divided by the number of distinct conflicts of both objects, 0 if any identifier is npos
+    */
+    template <typename T, typename Hash, typename KeyEqual>
+    double FrozenConflicts<T, Hash, KeyEqual>::similarity_id(id_type id1, id_type id2) const noexcept
+    {
+        if (id1 == npos || id2 == npos)
+            return 0;
+        auto range1 = neighbours(id1), range2 = neighbours(id2);
+        size_t common = Simd::intersect(range1.first, range1.size(), range2.first, range2.size(), nullptr);
+        return static_cast<double>(common) / static_cast<double>(range1.size() + range2.size() - common);
+    }
+
+    /*! \brief Computes the Jaccard index of the direct conflicts of 2 objects.
+    *   \return the number of common conflicts divided by the number of distinct conflicts of both objects, 0 if any has no conflict
+    */
+    template <typename T, typename Hash, typename KeyEqual>
+    double FrozenConflicts<T, Hash, KeyEqual>::conflict_similarity(const T& object1, const T& object2) const noexcept
+    {
+        return similarity_id(id(object1), id(object2));
+    }
+
+    /*! \brief Lists the pairs of distinct objects whose direct conflicts are similar.
+    *   \param threshold the minimum Jaccard index of the pairs, in (0, 1]
+    *   \return the pairs, each one given once, with their similarity
+    *
+    *   Candidates are found by prefix filtering: a pair reaching the threshold shares an identifier within the first
+    *   d - ceil(threshold * d) + 1 neighbours of each object of degree d, so only these prefixes are indexed.
+    *   Candidates whose degrees are too different are skipped, the others are checked with Simd::intersect().
+    */
+    template <typename T, typename Hash, typename KeyEqual>
+    std::vector<SimilarPair<T>> FrozenConflicts<T, Hash, KeyEqual>::similar_pairs(double threshold) const
+    {
+        assert(threshold > 0 && threshold <= 1 && "Threshold out of range.");
+        std::vector<SimilarPair<T>> result{};
+        auto prefix = [threshold](size_t degree)
+            {
+                // the tolerance avoids shortening a prefix when threshold * degree is rounded up to just above an integer
+                auto overlap = static_cast<size_t>(std::ceil(threshold * static_cast<double>(degree) - 1e-9));
+                return degree - std::min(degree, std::max<size_t>(overlap, 1)) + 1;
+            };
+        // objects indexed so far by each identifier of their prefix
+        std::vector<std::vector<id_type>> index(m_objects.size());
+        std::vector<id_type> seen(m_objects.size(), npos);
+        for (size_t current = 0; current < m_objects.size(); ++current)
+        {
+            auto id1 = static_cast<id_type>(current);
+            auto range1 = neighbours(id1);
+            auto length = prefix(range1.size());
+            for (size_t pos = 0; pos < length; ++pos)
+            {
+                for (id_type id2 : index[range1[pos]])
+                {
+                    if (seen[id2] == id1)
+                        continue;
+                    seen[id2] = id1;
+                    size_t degree1 = range1.size(), degree2 = m_offsets[id2 + 1] - m_offsets[id2];
+                    if (static_cast<double>(std::min(degree1, degree2)) < threshold * static_cast<double>(std::max(degree1, degree2)) - 1e-9)
+                        continue;
+                    double similarity = similarity_id(id2, id1);
+                    if (similarity >= threshold)
+                        result.push_back({ m_objects[id2], m_objects[id1], similarity });
+                }
+                index[range1[pos]].push_back(id1);
+            }
+        }
+        return result;
+    }
+
+    /*! \brief Removes from a bitset of candidates the objects in conflict with any member of a set.
+    *   \param set the identifiers of the members, npos ones being ignored
+    *   \param count the number of members
+    *   \param candidates the bitset of the candidate identifiers, of mask_words() words, updated in place
+    *
+    *   The neighbours of the members, their whole components in cascading mode or the objects within the depth, are gathered in a mask
+    *   that is then cleared from the candidates by the kernel selected for the processor, see Simd::and_not().
+    */
+    template <typename T, typename Hash, typename KeyEqual>
+    void FrozenConflicts<T, Hash, KeyEqual>::compatible_with(const id_type* set, size_t count, uint64_t* candidates) const
+    {
+        std::vector<uint64_t> mask(mask_words(), 0);
+        auto mark = [&mask](id_type id) { mask[id >> 6] |= uint64_t{ 1 } << (id & 63); };
+        for (size_t pos = 0; pos < count; ++pos)
+        {
+            id_type member = set[pos];
+            if (member == npos)
+                continue;
+            if (bounded())
+                bounded_search(member, m_depth, [&mark](id_type con) { mark(con); return true; });
+            else if (!m_cascading)
+            {
+                for (id_type con : neighbours(member))
+                    mark(con);
+            }
+            // a member already marked belongs to a component marked before
+            else if ((mask[member >> 6] & (uint64_t{ 1 } << (member & 63))) == 0)
+            {
+                for (id_type con : members(m_labels[member]))
+                    mark(con);
+            }
+        }
+        Simd::and_not(candidates, mask.data(), mask.size());
+    }
+
+    /*! \brief Lists the candidates that are not in conflict with any member of a set.
+    *   \param set the members
+    *   \param candidates the objects to check
+    *   \return the compatible candidates, in their given order
+    */
+    template <typename T, typename Hash, typename KeyEqual>
+    std::vector<T> FrozenConflicts<T, Hash, KeyEqual>::compatible_with(const std::vector<T>& set, const std::vector<T>& candidates) const
+    {
+        std::vector<id_type> members;
+        members.reserve(set.size());
+        for (auto& object : set)
+            members.push_back(id(object));
+        std::vector<id_type> ids;
+        ids.reserve(candidates.size());
+        std::vector<uint64_t> bits(mask_words(), 0);
+        for (auto& object : candidates)
+        {
+            id_type candidate = id(object);
+            ids.push_back(candidate);
+            if (candidate != npos)
+                bits[candidate >> 6] |= uint64_t{ 1 } << (candidate & 63);
+        }
+        compatible_with(members.data(), members.size(), bits.data());
+        std::vector<T> result;
+        for (size_t pos = 0; pos < candidates.size(); ++pos)
+        {
+            // objects without any relationship are compatible with all others
+            id_type candidate = ids[pos];
+            if (candidate == npos || (bits[candidate >> 6] & (uint64_t{ 1 } << (candidate & 63))) != 0)
+                result.push_back(candidates[pos]);
+        }
+        return result;
+    }
+
+    /*! \brief Takes an immutable snapshot of the relationships, optimized for queries, its objects being numbered by ReverseCuthillMcKee.
+    *   \return the snapshot, in the mode of the instance
+    */
+    template <typename T, typename Engine, typename Hash, typename KeyEqual, typename Validation>
+    FrozenConflicts<T, Hash, KeyEqual> Conflicts<T, Engine, Hash, KeyEqual, Validation>::freeze() const
+    {
+        return freeze(Ordering::ReverseCuthillMcKee, Pages::Default);
+    }
+
+    /*! \brief Takes an immutable snapshot of the relationships, optimized for queries.
+    *   \param ordering the numbering of the objects in the snapshot
+    *   \return the snapshot, in the mode of the instance
+    */
+    template <typename T, typename Engine, typename Hash, typename KeyEqual, typename Validation>
+    FrozenConflicts<T, Hash, KeyEqual> Conflicts<T, Engine, Hash, KeyEqual, Validation>::freeze(Ordering ordering) const
+    {
+        return freeze(ordering, Pages::Default);
+    }
+
+    /*! \brief Takes an immutable snapshot of the relationships, optimized for queries.
+    *   \param ordering the numbering of the objects in the snapshot
+    *   \param pages the kind of pages backing the large arrays of the snapshot
+    *   \return the snapshot, in the mode of the instance
+    */
+    template <typename T, typename Engine, typename Hash, typename KeyEqual, typename Validation>
+    FrozenConflicts<T, Hash, KeyEqual> Conflicts<T, Engine, Hash, KeyEqual, Validation>::freeze(Ordering ordering, Pages pages) const
+    {
+        return FrozenConflicts<T, Hash, KeyEqual>(m_conflicts, Depth{ m_depth }, ordering, pages);
+    }
+
+}
@@ -0,0 +1,240 @@
+#pragma once
+
+/*! \file conflicts_intervals.hpp
+*	\brief Implements the template class IntervalTree used by the interval storage engine.
+*   \author Christophe COUAILLET
+*/
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace Conflicts
+{
+
+    /*! \brief Class IntervalTree keeps half-open intervals [start, end) by key, and lists the ones overlapping a given interval.
+    *
+        The intervals are held in a treap ordered by start, each node keeping the largest end of its subtree, so that the subtrees
+        ending before the searched interval are skipped. Insertions and erasures take O(log n) expected time. The k intervals overlapping
+        a given one are listed in O(min(n, k log n)) expected time: a subtree whose largest end reaches the searched interval may still hold
+        no overlap, as its starts are only bounded on one side. Empty intervals overlap nothing and must not be inserted.
+        Position must be totally ordered by operator<.
+    */
+    template <typename K, typename Position = double, typename Hash = std::hash<K>, typename KeyEqual = std::equal_to<K>>
+    class IntervalTree
+    {
+    public:
+        using interval_type = std::pair<Position, Position>;
+
+        /*! \brief Gets the number of intervals. */
+        size_t size() const noexcept { return m_index.size(); }
+
+        /*! \brief Checks if the tree holds no interval. */
+        bool empty() const noexcept { return m_index.empty(); }
+
+        /*! \brief Removes all the intervals. */
+        void clear() noexcept { m_nodes.clear(); m_free.clear(); m_index.clear(); m_root = none; }
+
+        /*! \brief Gets the interval of a key, nullptr if the key has none. */
+        const interval_type* find(const K& key) const
+        {
+            auto itr = m_index.find(key);
+            return itr == m_index.end() ? nullptr : &m_nodes[itr->second].interval;
+        }
+
+        /*! \brief Checks if two intervals overlap. */
+        static bool overlap(const interval_type& interval1, const interval_type& interval2)
+        {
+            return interval1.first < interval2.second && interval2.first < interval1.second;
+        }
+
+        /*! \brief Sets the interval of a key, replacing its former one.
+        *   \param key the key
+        *   \param start,end the bounds of the interval, start being lower than end
+        */
+        void insert(const K& key, Position start, Position end)
+        {
+            erase(key);
+            size_t id;
+            if (m_free.empty())
+            {
+                id = m_nodes.size();
+                m_nodes.push_back(Node{ key, { start, end }, end, next_priority(), none, none });
+            }
+            else
+            {
+                id = m_free.back();
+                m_free.pop_back();
+                m_nodes[id] = Node{ key, { start, end }, end, next_priority(), none, none };
+            }
+            m_index.emplace(key, id);
+            auto [left, right] = split(m_root, start, id);
+            m_root = merge(merge(left, id), right);
+        }
+
+        /*! \brief Removes the interval of a key, returns false if the key has none. */
+        bool erase(const K& key)
+        {
+            auto itr = m_index.find(key);
+            if (itr == m_index.end())
+                return false;
+            size_t id = itr->second;
+            m_root = erase(m_root, m_nodes[id].interval.first, id);
+            m_free.push_back(id);
+            m_index.erase(itr);
+            return true;
+        }
+
+        /*! \brief Calls f with the key of each interval overlapping [start, end), by increasing start, until it returns false.
+        *   \return false if f stopped the iteration
+        */
+        template <typename F>
+        bool for_each_overlap(const Position& start, const Position& end, F&& f) const
+        {
+            return start < end ? visit(m_root, start, end, f) : true;
+        }
+
+        /*! \brief Calls f with the keys of each pair of overlapping intervals, until it returns false.
+        *
+            The intervals are swept by increasing start, each one being paired with the next ones starting before its end.
+        *   \return false if f stopped the iteration
+        */
+        template <typename F>
+        bool for_each_pair(F&& f) const
+        {
+            std::vector<size_t> order{};
+            order.reserve(size());
+            collect(m_root, order);
+            for (size_t i = 0; i < order.size(); ++i)
+            {
+                const Node& node = m_nodes[order[i]];
+                for (size_t j = i + 1; j < order.size() && m_nodes[order[j]].interval.first < node.interval.second; ++j)
+                    if (!f(node.key, m_nodes[order[j]].key))
+                        return false;
+            }
+            return true;
+        }
+
+    private:
+        static constexpr size_t none = static_cast<size_t>(-1);
+
+        struct Node
+        {
+            K key;
+            interval_type interval;
+            Position max_end;       // largest end of the subtree
+            uint32_t priority;      // the priority of a node is higher than the ones of its children
+            size_t left;
+            size_t right;
+        };
+
+        std::vector<Node> m_nodes{};
+        std::vector<size_t> m_free{};                           // nodes of the erased intervals
+        std::unordered_map<K, size_t, Hash, KeyEqual> m_index{};
+        size_t m_root{ none };
+        uint32_t m_seed{ 0x9E3779B9u };
+
+        // xorshift32
+        uint32_t next_priority() noexcept
+        {
+            m_seed ^= m_seed << 13;
+            m_seed ^= m_seed >> 17;
+            m_seed ^= m_seed << 5;
+            return m_seed;
+        }
+
+        // nodes are ordered by start, then by id
+        bool before(size_t id, const Position& start, size_t other) const
+        {
+            const Position& first = m_nodes[id].interval.first;
+            return first < start || (!(start < first) && id < other);
+        }
+
+        void update(size_t id)
+        {
+            Node& node = m_nodes[id];
+            node.max_end = node.interval.second;
+            if (node.left != none && node.max_end < m_nodes[node.left].max_end)
+                node.max_end = m_nodes[node.left].max_end;
+            if (node.right != none && node.max_end < m_nodes[node.right].max_end)
+                node.max_end = m_nodes[node.right].max_end;
+        }
+
+        // splits a subtree into the nodes before (start, id) and the others
+        std::pair<size_t, size_t> split(size_t root, const Position& start, size_t id)
+        {
+            if (root == none)
+                return { none, none };
+            if (before(root, start, id))
+            {
+                auto [left, right] = split(m_nodes[root].right, start, id);
+                m_nodes[root].right = left;
+                update(root);
+                return { root, right };
+            }
+            auto [left, right] = split(m_nodes[root].left, start, id);
+            m_nodes[root].left = right;
+            update(root);
+            return { left, root };
+        }
+
+        // merges two subtrees, all the nodes of the first one being before the ones of the second one
+        size_t merge(size_t left, size_t right)
+        {
+            if (left == none)
+                return right;
+            if (right == none)
+                return left;
+            if (m_nodes[left].priority > m_nodes[right].priority)
+            {
+                m_nodes[left].right = merge(m_nodes[left].right, right);
+                update(left);
+                return left;
+            }
+            m_nodes[right].left = merge(left, m_nodes[right].left);
+            update(right);
+            return right;
+        }
+
+        size_t erase(size_t root, const Position& start, size_t id)
+        {
+            if (root == id)
+                return merge(m_nodes[id].left, m_nodes[id].right);
+            if (before(root, start, id))
+                m_nodes[root].right = erase(m_nodes[root].right, start, id);
+            else
+                m_nodes[root].left = erase(m_nodes[root].left, start, id);
+            update(root);
+            return root;
+        }
+
+        template <typename F>
+        bool visit(size_t root, const Position& start, const Position& end, F& f) const
+        {
+            if (root == none || !(start < m_nodes[root].max_end))
+                return true;
+            const Node& node = m_nodes[root];
+            if (!visit(node.left, start, end, f))
+                return false;
+            // the nodes of the right subtree start after this one
+            if (!(node.interval.first < end))
+                return true;
+            if (start < node.interval.second && !f(node.key))
+                return false;
+            return visit(node.right, start, end, f);
+        }
+
+        void collect(size_t root, std::vector<size_t>& order) const
+        {
+            if (root == none)
+                return;
+            collect(m_nodes[root].left, order);
+            order.push_back(root);
+            collect(m_nodes[root].right, order);
+        }
+    };
+
+}
@@ -0,0 +1,272 @@
+#pragma once
+
+/*! \file conflicts_locks.hpp
+*	\brief Implements the template class ConflictLockManager, a lock table where objects in conflict exclude each other.
+*   \author Christophe COUAILLET
+*/
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "conflicts.hpp"
+
+namespace Conflicts
+{
+
+    /*! \brief Class ConflictLockManager locks objects, an object being held by one owner at a time and never together with an object
+    *   in conflict with it according to a Conflicts instance C.
+    *
+        The state of the objects is split over stripes, each one guarded by its own mutex and chosen by the hash of the objects, so that
+        no lock is global. Acquiring or releasing an object locks the stripes of the object and of the objects in conflict with it, by
+        increasing index to avoid deadlocks, which costs O(deg) for the direct conflicts, the whole component being listed in cascading
+        mode. Objects whose conflicts fall in distinct stripes are thus locked concurrently without contention.
+
+        The owners waiting for an object are queued in FIFO order: only the oldest one tries to take it, and it is woken up when the object
+        or an object in conflict with it is released. No fairness is ensured between distinct objects: the oldest owner waiting for an
+        object may wait as long as the objects in conflict with it keep being taken.
+        \warning The relationships must not change while the manager is in use. Locks are not reentrant, an owner acquiring an object it
+        already holds waits forever.
+    */
+    template <typename C>
+    class ConflictLockManager
+    {
+    public:
+        using value_type = typename C::value_type;
+        static_assert(!is_expiring_v<typename C::storage_type, value_type>, "Expiring relationships change over time, the lock table needs fixed ones.");
+
+        /*! \brief Constructor.
+        *   \param conflicts the relationships between the objects, that must outlive the manager
+        *   \param stripes the number of stripes, at least 1
+        */
+        explicit ConflictLockManager(const C& conflicts, size_t stripes = 64)
+            : m_conflicts(conflicts), m_stripes(std::max<size_t>(stripes, 1)) {}
+
+        ConflictLockManager(const ConflictLockManager&) = delete;
+        ConflictLockManager& operator=(const ConflictLockManager&) = delete;
+
+        /*! \brief Takes an object, waiting until it and all the objects in conflict with it are released. */
+        void acquire(const value_type& object) { take<wait_type>(object, nullptr); }
+
+        /*! \brief Takes an object if it and all the objects in conflict with it are released, and no other owner is waiting for it.
+        *   \return true if the object is taken
+        */
+        bool try_acquire(const value_type& object)
+        {
+            Request request{ m_conflicts, object, *this };
+            lock(request.stripes);
+            // the slot of an object exists while it is held or waited for
+            bool result = m_stripes[request.home].slots.count(object) == 0 && available(request);
+            if (result)
+                slot(object).held = true;
+            unlock(request.stripes);
+            return result;
+        }
+
+        /*! \brief Takes an object, waiting at most for the given duration.
+        *   \return true if the object is taken, false once the duration is elapsed
+        */
+        template <typename Rep, typename Period>
+        bool try_acquire_for(const value_type& object, const std::chrono::duration<Rep, Period>& duration)
+        {
+            return try_acquire_until(object, std::chrono::steady_clock::now() + duration);
+        }
+
+        /*! \brief Takes an object, waiting at most until the given time point.
+        *   \return true if the object is taken, false once the time point is reached
+        */
+        template <typename Clock, typename Duration>
+        bool try_acquire_until(const value_type& object, const std::chrono::time_point<Clock, Duration>& deadline)
+        {
+            auto until = [&deadline](std::condition_variable& wakeup, std::unique_lock<std::mutex>& lock, bool& woken)
+                {
+                    return wakeup.wait_until(lock, deadline, [&woken] { return woken; });
+                };
+            return take(object, &until);
+        }
+
+        /*! \brief Releases an object, waking up the oldest owners waiting for it and for the objects in conflict with it.
+        *   \param object the object, that must be held
+        */
+        void release(const value_type& object)
+        {
+            Request request{ m_conflicts, object, *this };
+            lock(request.stripes);
+            auto& slots = m_stripes[request.home].slots;
+            auto itr = slots.find(object);
+            assert(itr != slots.end() && itr->second.held && "Object is not held.");
+            itr->second.held = false;
+            if (itr->second.waiters.empty())
+                slots.erase(itr);
+            else
+                wake(itr->second);
+            for (auto& con : request.peers)
+            {
+                auto& peer_slots = m_stripes[stripe(con)].slots;
+                auto peer = peer_slots.find(con);
+                if (peer != peer_slots.end() && !peer->second.waiters.empty())
+                    wake(peer->second);
+            }
+            unlock(request.stripes);
+        }
+
+        /*! \brief Checks if an object is held. */
+        bool held(const value_type& object) const
+        {
+            const Stripe& home = m_stripes[stripe(object)];
+            std::lock_guard<std::mutex> lock(home.mutex);
+            auto itr = home.slots.find(object);
+            return itr != home.slots.end() && itr->second.held;
+        }
+
+    private:
+        using T = value_type;
+        using Hash = typename C::hasher;
+        using KeyEqual = typename C::key_equal;
+
+        // an owner waiting for an object
+        struct Waiter
+        {
+            std::condition_variable wakeup{};
+            bool woken{ false };        // guarded by the mutex of the stripe of the object
+        };
+
+        // state of an object held or waited for
+        struct Slot
+        {
+            bool held{ false };
+            std::deque<Waiter*> waiters{};
+        };
+
+        struct Stripe
+        {
+            mutable std::mutex mutex{};
+            std::unordered_map<T, Slot, Hash, KeyEqual> slots{};
+        };
+
+        // objects in conflict with an object and the stripes to lock, by increasing index
+        struct Request
+        {
+            std::vector<T> peers;
+            std::vector<size_t> stripes{};
+            size_t home;
+
+            Request(const C& conflicts, const T& object, const ConflictLockManager& manager)
+                : peers(conflicts.all_conflicts(object)), home(manager.stripe(object))
+            {
+                stripes.reserve(peers.size() + 1);
+                stripes.push_back(home);
+                for (auto& con : peers)
+                    stripes.push_back(manager.stripe(con));
+                std::sort(stripes.begin(), stripes.end());
+                stripes.erase(std::unique(stripes.begin(), stripes.end()), stripes.end());
+            }
+        };
+
+        using wait_type = bool(std::condition_variable&, std::unique_lock<std::mutex>&, bool&);
+
+        const C& m_conflicts;
+        std::vector<Stripe> m_stripes;
+
+        size_t stripe(const T& object) const { return Hash{}(object) % m_stripes.size(); }
+
+        Slot& slot(const T& object) { return m_stripes[stripe(object)].slots[object]; }
+
+        void lock(const std::vector<size_t>& stripes)
+        {
+            for (size_t index : stripes)
+                m_stripes[index].mutex.lock();
+        }
+
+        void unlock(const std::vector<size_t>& stripes)
+        {
+            for (auto itr = stripes.rbegin(); itr != stripes.rend(); ++itr)
+                m_stripes[*itr].mutex.unlock();
+        }
+
+        // checks, the stripes being locked, that neither the object nor the objects in conflict with it are held
+        bool available(const Request& request) const
+        {
+            for (auto& con : request.peers)
+            {
+                auto& slots = m_stripes[stripe(con)].slots;
+                auto itr = slots.find(con);
+                if (itr != slots.end() && itr->second.held)
+                    return false;
+            }
+            return true;
+        }
+
+        static void wake(Slot& slot)
+        {
+            Waiter* waiter = slot.waiters.front();
+            waiter->woken = true;
+            waiter->wakeup.notify_one();
+        }
+
+        // takes an object, waiting with the given function until woken up, without limit if it is null
+        template <typename F>
+        bool take(const T& object, F* until)
+        {
+            Request request{ m_conflicts, object, *this };
+            Waiter waiter{};
+            lock(request.stripes);
+            Slot* own = &slot(object);
+            if (!own->held && own->waiters.empty() && available(request))
+            {
+                own->held = true;
+                unlock(request.stripes);
+                return true;
+            }
+            own->waiters.push_back(&waiter);
+            bool timeout{ false };
+            while (true)
+            {
+                // the stripe of the object is kept locked until waiting, so that no wakeup is missed
+                for (size_t index : request.stripes)
+                    if (index != request.home)
+                        m_stripes[index].mutex.unlock();
+                {
+                    std::unique_lock<std::mutex> home(m_stripes[request.home].mutex, std::adopt_lock);
+                    if (until == nullptr)
+                        waiter.wakeup.wait(home, [&waiter] { return waiter.woken; });
+                    else
+                        timeout = !(*until)(waiter.wakeup, home, waiter.woken);
+                    waiter.woken = false;
+                    home.release();
+                }
+                m_stripes[request.home].mutex.unlock();
+                lock(request.stripes);
+                // only the oldest waiter tries, the slot being kept while it is waited for
+                own = &slot(object);
+                if (own->waiters.front() == &waiter && !own->held && available(request))
+                {
+                    own->held = true;
+                    own->waiters.pop_front();
+                    unlock(request.stripes);
+                    return true;
+                }
+                if (timeout)
+                    break;
+            }
+            bool oldest = own->waiters.front() == &waiter;
+            own->waiters.erase(std::find(own->waiters.begin(), own->waiters.end(), &waiter));
+            if (own->waiters.empty())
+            {
+                if (!own->held)
+                    m_stripes[request.home].slots.erase(object);
+            }
+            else if (oldest && !own->held)
+                wake(*own);
+            unlock(request.stripes);
+            return false;
+        }
+    };
+
+}
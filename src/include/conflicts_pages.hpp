@@ -0,0 +1,108 @@
+#pragma once
+
+/*! \file conflicts_pages.hpp
+*	\brief Implements the template class PageAllocator that backs the large arrays of a frozen snapshot with huge pages.
+*   \author Christophe COUAILLET
+*/
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+namespace Conflicts
+{
+
+    /*! \brief Kind of memory pages backing the large arrays of a frozen snapshot. */
+    enum class Pages
+    {
+        Default,            //!< regular allocation
+        Transparent,        //!< anonymous mapping advised for transparent huge pages (madvise(MADV_HUGEPAGE))
+        Explicit            //!< explicit huge pages (MAP_HUGETLB), transparent huge pages if none is reserved
+    };
+
+    /*! \brief Allocator that maps the large blocks on huge pages, reducing the TLB misses of the traversals over big graphs.
+    *
+        Only blocks of at least HugePageSize bytes are mapped, smaller ones and all blocks on other systems than Linux use the
+        regular allocation. The kind of pages is a state of the allocator and propagates with the containers using it.
+    */
+    template <typename U>
+    class PageAllocator
+    {
+    public:
+        using value_type = U;
+        using propagate_on_container_copy_assignment = std::true_type;
+        using propagate_on_container_move_assignment = std::true_type;
+        using propagate_on_container_swap = std::true_type;
+
+        /*! \brief Size of a huge page, also the minimal size of a mapped block. */
+        static constexpr size_t HugePageSize = size_t{ 2 } << 20;
+
+        PageAllocator(Pages pages = Pages::Default) noexcept : m_pages(pages) {}
+
+        template <typename V>
+        PageAllocator(const PageAllocator<V>& other) noexcept : m_pages(other.pages()) {}
+
+        /*! \brief Gets the kind of pages used by the allocator. */
+        Pages pages() const noexcept { return m_pages; }
+
+        U* allocate(size_t n)
+        {
+            size_t bytes = n * sizeof(U);
+            if (!mapped(bytes))
+                return static_cast<U*>(::operator new(bytes));
+#ifdef __linux__
+            size_t length = round(bytes);
+            void* block = MAP_FAILED;
+#ifdef MAP_HUGETLB
+            if (m_pages == Pages::Explicit)
+                block = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+#endif
+            if (block == MAP_FAILED)
+            {
+                // no huge page reserved or not requested: the kernel is advised to back the mapping with transparent huge pages
+                block = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+                if (block == MAP_FAILED)
+                    throw std::bad_alloc();
+#ifdef MADV_HUGEPAGE
+                madvise(block, length, MADV_HUGEPAGE);
+#endif
+            }
+            return static_cast<U*>(block);
+#else
+            return nullptr;
+#endif
+        }
+
+        void deallocate(U* block, size_t n) noexcept
+        {
+            size_t bytes = n * sizeof(U);
+            if (!mapped(bytes))
+                ::operator delete(block);
+#ifdef __linux__
+            else
+                munmap(block, round(bytes));
+#endif
+        }
+
+        friend bool operator==(const PageAllocator& alloc1, const PageAllocator& alloc2) noexcept { return alloc1.m_pages == alloc2.m_pages; }
+        friend bool operator!=(const PageAllocator& alloc1, const PageAllocator& alloc2) noexcept { return !(alloc1 == alloc2); }
+
+    private:
+        Pages m_pages{ Pages::Default };
+
+        bool mapped(size_t bytes) const noexcept
+        {
+#ifdef __linux__
+            return m_pages != Pages::Default && bytes >= HugePageSize;
+#else
+            return false;
+#endif
+        }
+        static size_t round(size_t bytes) noexcept { return (bytes + HugePageSize - 1) & ~(HugePageSize - 1); }
+    };
+
+}
@@ -0,0 +1,144 @@
+#pragma once
+
+/*! \file conflicts_ranking.hpp
+*	\brief Implements the template class Ranking, that keeps keys ordered by a count updated incrementally.
+*   \author Christophe COUAILLET
+*/
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <list>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace Conflicts
+{
+
+    /*! \brief Class Ranking keeps keys ordered by a positive count, so that the keys with the highest counts are listed in O(k).
+    *
+        The keys are held in buckets of equal count, the buckets being linked by increasing count and only existing while not empty.
+        Changing a count by delta moves its key across at most |delta| buckets, a change of 1 being performed in constant time.
+        A key whose count drops to 0 is removed.
+    */
+    template <typename K, typename Hash = std::hash<K>, typename KeyEqual = std::equal_to<K>>
+    class Ranking
+    {
+    public:
+        Ranking() = default;
+        Ranking(Ranking&&) = default;
+        Ranking& operator=(Ranking&&) = default;
+
+        /*! \brief Copy constructor. The positions of the keys are rebuilt in the new buckets. */
+        Ranking(const Ranking& other) { copy(other); }
+
+        /*! \brief Copy assignment. The positions of the keys are rebuilt in the new buckets. */
+        Ranking& operator=(const Ranking& other)
+        {
+            if (this != &other)
+            {
+                clear();
+                copy(other);
+            }
+            return *this;
+        }
+
+        /*! \brief Removes all keys. */
+        void clear() noexcept { m_positions.clear(); m_buckets.clear(); }
+
+        /*! \brief Checks if any key has a count. */
+        bool empty() const noexcept { return m_positions.empty(); }
+
+        /*! \brief Gets the number of keys. */
+        size_t size() const noexcept { return m_positions.size(); }
+
+        /*! \brief Gets the count of a key, 0 if it is not ranked. */
+        size_t count(const K& key) const noexcept
+        {
+            auto itr = m_positions.find(key);
+            return itr == m_positions.end() ? 0 : itr->second.first->count;
+        }
+
+        /*! \brief Changes the count of a key.
+        *   \param key the key to update, added if not ranked yet
+        *   \param delta the change of the count, that must not become negative
+        */
+        void adjust(const K& key, std::ptrdiff_t delta)
+        {
+            auto pos = m_positions.find(key);
+            size_t current = pos == m_positions.end() ? 0 : pos->second.first->count;
+            assert((delta >= 0 || current >= static_cast<size_t>(-delta)) && "Count can't be negative.");
+            size_t target = current + delta;
+            if (target == current)
+                return;
+            if (target == 0)
+            {
+                auto [bucket, itr] = pos->second;
+                bucket->keys.erase(itr);
+                if (bucket->keys.empty())
+                    m_buckets.erase(bucket);
+                m_positions.erase(pos);
+                return;
+            }
+            // first bucket whose count is not lower than the target, searched from the current one
+            auto bucket = pos == m_positions.end() ? m_buckets.begin() : pos->second.first;
+            if (target > current)
+                while (bucket != m_buckets.end() && bucket->count < target)
+                    ++bucket;
+            else
+                while (bucket != m_buckets.begin() && std::prev(bucket)->count >= target)
+                    --bucket;
+            if (bucket == m_buckets.end() || bucket->count != target)
+                bucket = m_buckets.insert(bucket, Bucket{ target, {} });
+            if (pos == m_positions.end())
+            {
+                bucket->keys.push_back(key);
+                m_positions.emplace(key, std::make_pair(bucket, std::prev(bucket->keys.end())));
+                return;
+            }
+            auto [from, itr] = pos->second;
+            bucket->keys.splice(bucket->keys.end(), from->keys, itr);
+            pos->second.first = bucket;
+            if (from->keys.empty())
+                m_buckets.erase(from);
+        }
+
+        /*! \brief Lists the keys with the highest counts.
+        *   \param k the maximum number of keys to list
+        *   \return the keys and their counts, by decreasing count, keys of equal count being in no particular order
+        */
+        std::vector<std::pair<K, size_t>> top(size_t k) const
+        {
+            std::vector<std::pair<K, size_t>> result{};
+            result.reserve(std::min(k, size()));
+            for (auto bucket = m_buckets.rbegin(); bucket != m_buckets.rend() && result.size() < k; ++bucket)
+                for (auto itr = bucket->keys.begin(); itr != bucket->keys.end() && result.size() < k; ++itr)
+                    result.emplace_back(*itr, bucket->count);
+            return result;
+        }
+
+    private:
+        struct Bucket
+        {
+            size_t count;
+            std::list<K> keys;
+        };
+        using bucket_iterator = typename std::list<Bucket>::iterator;
+
+        std::list<Bucket> m_buckets{};          // by increasing count
+        std::unordered_map<K, std::pair<bucket_iterator, typename std::list<K>::iterator>, Hash, KeyEqual> m_positions{};
+
+        void copy(const Ranking& other)
+        {
+            m_buckets = other.m_buckets;
+            m_positions.reserve(other.m_positions.size());
+            for (auto bucket = m_buckets.begin(); bucket != m_buckets.end(); ++bucket)
+                for (auto itr = bucket->keys.begin(); itr != bucket->keys.end(); ++itr)
+                    m_positions.emplace(*itr, std::make_pair(bucket, itr));
+        }
+    };
+
+}
@@ -0,0 +1,465 @@
+#pragma once
+
+/*! \file conflicts_resolver.hpp
+*	\brief Implements the template classes Resolver and IncrementalResolver, that select a set of objects meeting their requirements
+*   and free of conflicts.
+*   \author Christophe COUAILLET
+*/
+
+#include <algorithm>
+#include <cstddef>
+#include <optional>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include <requirements.hpp>
+
+#include "conflicts.hpp"
+
+namespace Conflicts
+{
+
+    /*! \brief Result of a resolution, see Resolver. */
+    template <typename T>
+    struct Resolution
+    {
+        bool satisfied{ false };        // all the required objects are selected with their requirements, without conflict
+        std::vector<T> selected{};      // objects selected, by order of selection
+        std::vector<T> rejected{};      // wanted objects left out, by order of request
+        std::vector<T> conflict{};      // if not satisfied, an object that could not be selected and the object preventing it, itself if it is forbidden
+    };
+
+    /*! \brief Objects whose selection changed after a relationship or a requirement changed, see IncrementalResolver. */
+    template <typename T>
+    struct SelectionChanges
+    {
+        std::vector<T> selected{};      // objects now selected
+        std::vector<T> unselected{};    // objects no longer selected
+
+        /*! \brief Checks if the selection is unchanged. */
+        bool empty() const noexcept { return selected.empty() && unselected.empty(); }
+    };
+
+    /*! \brief Class Resolver selects the objects required or wanted with all their requirements, given by an instance R of
+    *   Requirements::Requirements, so that no selected object is in conflict with another one according to a Conflicts instance C.
+    *
+        An object requires all its requirements, so that the problem is a satisfiability problem with two literals per clause: "a requires b"
+        is the clause (not a or b), "a is in conflict with b" the clause (not a or not b). Selecting an object is thus unit propagation over
+        the implication lists given by the requirements, the lists of both literals of a clause being the watches of the clause, and
+        the objects required can be selected together if and only if propagating them meets no conflict, the other objects being left out.
+        Each object is visited once, for O(objects + relationships) resolution.
+
+        Wanted objects are decisions taken in turn once the required ones are selected: a wanted object whose propagation meets a conflict
+        has its propagation undone from the trail, and is learned as refused for the remaining decisions, the selection only growing.
+        In cascading mode, an object is in conflict with the other members of its component, which are labelled once per resolution.
+        \warning The relationships and the requirements must not change during a resolution.
+        \sa IncrementalResolver to keep a resolution up to date as the relationships and the requirements change.
+    */
+    template <typename C, typename R = ::Requirements::Requirements<typename C::value_type>>
+    class Resolver
+    {
+    public:
+        using value_type = typename C::value_type;
+        using resolution_type = Resolution<value_type>;
+
+        /*! \brief Constructor.
+        *   \param conflicts the relationships between the objects, that must outlive the resolver
+        *   \param requirements the requirements of the objects, that must outlive the resolver
+        */
+        Resolver(const C& conflicts, const R& requirements) : m_conflicts(conflicts), m_requirements(requirements) {}
+
+        /*! \brief Selects objects with their requirements.
+        *   \param required the objects that must be selected
+        *   \param wanted the objects selected when possible, by decreasing priority
+        *   \param forbidden the objects that must not be selected
+        *   \return the selection, stopped before the first required object that can't be selected
+        */
+        resolution_type resolve(const std::vector<value_type>& required, const std::vector<value_type>& wanted = {},
+            const std::vector<value_type>& forbidden = {}) const
+        {
+            Search search{ *this, required, wanted, forbidden, false };
+            search.run(0);
+            return search.resolution();
+        }
+
+    protected:
+        using T = value_type;
+        using Hash = typename C::hasher;
+        using KeyEqual = typename C::key_equal;
+
+        static constexpr size_t npos = C::npos;
+        static constexpr size_t refused = static_cast<size_t>(-1);
+
+        const C& m_conflicts;
+        const R& m_requirements;
+
+        // outcome of a decision, the selection of a required or wanted object
+        struct Level
+        {
+            size_t mark;                // size of the trail before the decision
+            bool accepted{ true };
+            bool learned{ false };      // the object is refused by the decision
+            std::vector<T> conflict{};  // if not accepted
+            std::vector<T> visited{};   // if not accepted and recorded, the objects selected before the conflict was met
+        };
+
+        // state of a resolution
+        struct Search
+        {
+            const Resolver& resolver;
+            const std::vector<T>& required;
+            const std::vector<T>& wanted;
+            bool record;                                                    // keeps the objects visited by the decisions not accepted
+            std::unordered_map<T, size_t, Hash, KeyEqual> values{};        // level of each object selected, refused for the refused ones
+            std::vector<T> trail{};                                         // objects selected, by order of selection
+            std::vector<Level> levels{};
+            std::unordered_map<T, size_t, Hash, KeyEqual> labels{};        // in cascading mode, component of each object in relationship
+            std::unordered_map<size_t, T> owners{};                         // in cascading mode, selected member of each component
+            std::vector<T> conflict{};                                      // last conflict met
+
+            Search(const Resolver& owner, const std::vector<T>& required_objects, const std::vector<T>& wanted_objects,
+                const std::vector<T>& forbidden, bool recording)
+                : resolver(owner), required(required_objects), wanted(wanted_objects), record(recording)
+            {
+                for (auto& object : forbidden)
+                    values[object] = refused;
+                if (resolver.m_conflicts.cascading())
+                    labels = resolver.m_conflicts.component_labels();
+            }
+
+            bool satisfied() const { return levels.size() > required.size() || (levels.size() == required.size() && (levels.empty() || levels.back().accepted)); }
+
+            const T& decision(size_t level) const { return level < required.size() ? required[level] : wanted[level - required.size()]; }
+
+            bool selected(const T& object) const
+            {
+                auto itr = values.find(object);
+                return itr != values.end() && itr->second != refused;
+            }
+
+            // takes the decisions from the given one, the former ones being kept, until a required object can't be selected
+            void run(size_t from)
+            {
+                for (size_t level = from; level < required.size() + wanted.size(); ++level)
+                {
+                    const T& object = decision(level);
+                    levels.push_back(Level{ trail.size() });
+                    Level& current = levels.back();
+                    // select() may rehash the values, only whether the object was already decided is kept
+                    auto itr = values.find(object);
+                    const bool known = itr != values.end();
+                    if (known && itr->second != refused)
+                        continue;
+                    if (!known && select(object, level))
+                        continue;
+                    current.accepted = false;
+                    current.conflict = !known ? std::move(conflict) : std::vector<T>{ object, object };
+                    if (record)
+                        current.visited.assign(trail.begin() + current.mark, trail.end());
+                    undo(current.mark);
+                    if (level < required.size())
+                        return;
+                    // learned: the selection only grows, the object can't be selected by a later decision either
+                    if (!known)
+                    {
+                        values.emplace(object, refused);
+                        current.learned = true;
+                    }
+                }
+            }
+
+            resolution_type resolution() const
+            {
+                resolution_type result{};
+                result.satisfied = satisfied();
+                result.selected = trail;
+                for (size_t level = required.size(); level < levels.size(); ++level)
+                    if (!levels[level].accepted)
+                        result.rejected.push_back(decision(level));
+                if (!result.satisfied)
+                    result.conflict = levels.back().conflict;
+                return result;
+            }
+
+            size_t label(const T& object) const
+            {
+                auto itr = labels.find(object);
+                return itr == labels.end() ? npos : itr->second;
+            }
+
+            // selects an object and propagates its requirements, returns false and sets the conflict if one is met
+            bool select(const T& object, size_t level)
+            {
+                std::vector<T> pending{ object };
+                while (!pending.empty())
+                {
+                    T current = std::move(pending.back());
+                    pending.pop_back();
+                    auto [itr, inserted] = values.try_emplace(current, level);
+                    if (!inserted)
+                    {
+                        if (itr->second != refused)
+                            continue;
+                        conflict = { current, current };
+                        return false;
+                    }
+                    trail.push_back(current);
+                    if (!clear_of_conflicts(current))
+                        return false;
+                    for (auto& requirement : resolver.m_requirements.requirements(current))
+                    {
+                        auto value = values.find(requirement);
+                        if (value == values.end())
+                            pending.push_back(requirement);
+                        else if (value->second == refused)
+                        {
+                            conflict = { current, requirement };
+                            return false;
+                        }
+                    }
+                }
+                return true;
+            }
+
+            // checks that no selected object is in conflict with a newly selected one
+            bool clear_of_conflicts(const T& object)
+            {
+                if (resolver.m_conflicts.cascading())
+                {
+                    size_t component = label(object);
+                    if (component == npos)
+                        return true;
+                    auto [itr, inserted] = owners.try_emplace(component, object);
+                    if (inserted)
+                        return true;
+                    conflict = { object, itr->second };
+                    return false;
+                }
+                for (auto& con : resolver.m_conflicts.all_conflicts(object))
+                    if (selected(con))
+                    {
+                        conflict = { object, con };
+                        return false;
+                    }
+                return true;
+            }
+
+            // unselects the objects selected since the mark
+            void undo(size_t mark)
+            {
+                while (trail.size() > mark)
+                {
+                    const T& object = trail.back();
+                    if (resolver.m_conflicts.cascading())
+                    {
+                        auto itr = owners.find(label(object));
+                        if (itr != owners.end() && KeyEqual{}(itr->second, object))
+                            owners.erase(itr);
+                    }
+                    values.erase(object);
+                    trail.pop_back();
+                }
+            }
+        };
+    };
+
+    /*! \brief Class IncrementalResolver keeps the resolution of a Resolver up to date as the relationships and the requirements change,
+    *   repairing only the decisions affected by each change.
+    *
+        The resolution keeps the level of each decision, a required or wanted object, and the trail of the objects selected by each one.
+        Once a relationship or a requirement is changed in C or R, the matching notification checks only its two objects to find
+        the first decision whose outcome may change, with direct conflicts:
+        \li an added conflict matters if both objects are selected, from the later decision that selected one of them.
+        \li a removed conflict matters for the first decision refused because of it.
+        \li an added requirement of a selected object matters if the object required was not selected by then.
+        \li a removed requirement matters for the decision that selected its dependent object, and for the first refused decision that
+        visited it, the objects visited by the refused decisions being indexed.
+
+        The decisions are then taken again from this one, the former ones and their learned refusals being kept, so that the cost
+        depends on the decisions after the change only. In cascading mode and with a bounded depth, a relationship changes the conflicts
+        of whole components, and all the decisions are taken again. Each notification reports the objects whose selection changed,
+        the result always being the one of Resolver::resolve().
+        \warning The notifications must be given after each change, in order.
+    */
+    template <typename C, typename R = ::Requirements::Requirements<typename C::value_type>>
+    class IncrementalResolver : private Resolver<C, R>
+    {
+        using base_type = Resolver<C, R>;
+
+    public:
+        using value_type = typename base_type::value_type;
+        using resolution_type = typename base_type::resolution_type;
+        using changes_type = SelectionChanges<value_type>;
+
+        /*! \brief Constructor, that resolves the selection.
+        *   \param conflicts the relationships between the objects, that must outlive the resolver
+        *   \param requirements the requirements of the objects, that must outlive the resolver
+        *   \param required the objects that must be selected
+        *   \param wanted the objects selected when possible, by decreasing priority
+        *   \param forbidden the objects that must not be selected
+        */
+        IncrementalResolver(const C& conflicts, const R& requirements, std::vector<value_type> required, std::vector<value_type> wanted = {},
+            std::vector<value_type> forbidden = {})
+            : base_type(conflicts, requirements), m_required(std::move(required)), m_wanted(std::move(wanted)), m_forbidden(std::move(forbidden))
+        {
+            m_search.emplace(static_cast<const base_type&>(*this), m_required, m_wanted, m_forbidden, true);
+            m_search->run(0);
+            index(0);
+        }
+
+        IncrementalResolver(const IncrementalResolver&) = delete;
+        IncrementalResolver& operator=(const IncrementalResolver&) = delete;
+
+        /*! \brief Gets the current resolution. */
+        resolution_type resolution() const { return m_search->resolution(); }
+
+        /*! \brief Checks if an object is selected. */
+        bool selected(const value_type& object) const { return m_search->selected(object); }
+
+        /*! \brief Updates the selection once a conflict relationship is added between two objects. */
+        changes_type conflict_added(const value_type& object1, const value_type& object2)
+        {
+            if (!direct())
+                return repair(0);
+            size_t level1 = level(object1), level2 = level(object2);
+            if (level1 == refused || level2 == refused)
+                return changes_type{};
+            return repair(std::max(level1, level2));
+        }
+
+        /*! \brief Updates the selection once a conflict relationship is removed between two objects. */
+        changes_type conflict_removed(const value_type& object1, const value_type& object2)
+        {
+            if (!direct())
+                return repair(0);
+            size_t from = refused;
+            for (const T* object : { &object1, &object2 })
+            {
+                auto itr = m_attempts.find(*object);
+                if (itr == m_attempts.end())
+                    continue;
+                // the conflict met by a refused decision still holds unless it is the removed one
+                for (size_t level : itr->second)
+                {
+                    auto& conflict = m_search->levels[level].conflict;
+                    if ((KeyEqual{}(conflict[0], object1) && KeyEqual{}(conflict[1], object2))
+                        || (KeyEqual{}(conflict[0], object2) && KeyEqual{}(conflict[1], object1)))
+                    {
+                        from = std::min(from, level);
+                        break;
+                    }
+                }
+            }
+            return from == refused ? changes_type{} : repair(from);
+        }
+
+        /*! \brief Updates the selection once a requirement is added to an object. */
+        changes_type requirement_added(const value_type& object, const value_type& requirement)
+        {
+            size_t level1 = level(object);
+            if (level1 == refused)
+                return changes_type{};
+            // the decision that selected the object selects the requirement too, unless it was selected by then
+            size_t level2 = level(requirement);
+            if (level2 != refused && level2 <= level1)
+                return changes_type{};
+            return repair(level1);
+        }
+
+        /*! \brief Updates the selection once a requirement is removed from an object. */
+        changes_type requirement_removed(const value_type& object, const value_type& requirement)
+        {
+            size_t from = refused;
+            auto itr = m_attempts.find(object);
+            if (itr != m_attempts.end())
+                from = itr->second.front();
+            size_t level1 = level(object), level2 = level(requirement);
+            if (level1 != refused && (level2 == refused || level2 >= level1))
+                from = std::min(from, level1);
+            return from == refused ? changes_type{} : repair(from);
+        }
+
+    private:
+        using typename base_type::T;
+        using typename base_type::KeyEqual;
+        using typename base_type::Hash;
+        using typename base_type::Search;
+        using typename base_type::Level;
+        using base_type::refused;
+
+        std::vector<T> m_required;
+        std::vector<T> m_wanted;
+        std::vector<T> m_forbidden;
+        std::optional<Search> m_search{};
+        std::unordered_map<T, std::vector<size_t>, Hash, KeyEqual> m_attempts{};   // refused decisions that visited each object, increasing
+
+        bool direct() const noexcept { return !this->m_conflicts.cascading() && this->m_conflicts.depth() == 1; }
+
+        // level of the decision that selected an object, refused if it is not selected
+        size_t level(const T& object) const
+        {
+            auto itr = m_search->values.find(object);
+            return itr == m_search->values.end() ? refused : itr->second;
+        }
+
+        // indexes the objects visited by the refused decisions from the given one
+        void index(size_t from)
+        {
+            for (size_t level = from; level < m_search->levels.size(); ++level)
+                for (auto& object : m_search->levels[level].visited)
+                    m_attempts[object].push_back(level);
+        }
+
+        // takes the decisions again from the given one
+        changes_type repair(size_t from)
+        {
+            if (!direct())
+            {
+                // the components are labelled again
+                std::vector<T> former = std::move(m_search->trail);
+                m_search.emplace(static_cast<const base_type&>(*this), m_required, m_wanted, m_forbidden, true);
+                m_attempts.clear();
+                m_search->run(0);
+                index(0);
+                return changes(former, 0);
+            }
+            size_t mark = m_search->levels[from].mark;
+            std::vector<T> former(m_search->trail.begin() + mark, m_search->trail.end());
+            for (size_t level = m_search->levels.size(); level-- > from;)
+            {
+                Level& outcome = m_search->levels[level];
+                if (outcome.learned)
+                    m_search->values.erase(m_search->decision(level));
+                for (auto& object : outcome.visited)
+                {
+                    auto itr = m_attempts.find(object);
+                    itr->second.pop_back();
+                    if (itr->second.empty())
+                        m_attempts.erase(itr);
+                }
+            }
+            m_search->levels.resize(from);
+            m_search->undo(mark);
+            m_search->run(from);
+            index(from);
+            return changes(former, mark);
+        }
+
+        // compares the objects selected since the mark with the former ones
+        changes_type changes(const std::vector<T>& former, size_t mark) const
+        {
+            changes_type result{};
+            std::unordered_set<T, Hash, KeyEqual> previous(former.begin(), former.end());
+            for (size_t pos = mark; pos < m_search->trail.size(); ++pos)
+                if (previous.erase(m_search->trail[pos]) == 0)
+                    result.selected.push_back(m_search->trail[pos]);
+            for (auto& object : former)
+                if (previous.count(object) > 0)
+                    result.unselected.push_back(object);
+            return result;
+        }
+    };
+
+}
@@ -0,0 +1,275 @@
+#pragma once
+
+/*! \file conflicts_simd.hpp
+*	\brief Implements the intersection kernels of sorted identifier lists and bitsets, selected at runtime according to the processor.
+*   \author Christophe COUAILLET
+*/
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define CONFLICTS_SIMD_X86
+#include <immintrin.h>
+#endif
+
+namespace Conflicts
+{
+    namespace Simd
+    {
+
+        /*! \brief Instruction sets of the kernels.
+        *
+            There is no SSE4 kernel: the packed string comparisons of SSE4.2 (PCMPESTRM) compare 8 or 16 bits units only, and SSE4.1 adds
+            no instruction to the 4 x 4 blocks comparison of 32 bits identifiers, so that processors with SSE4 run the SSE2 kernel.
+        */
+        enum class Level
+        {
+            Scalar,     //!< portable merge and galloping
+            Sse,        //!< 4 x 4 blocks compared with SSE2
+            Avx2        //!< 8 x 8 blocks compared with AVX2
+        };
+
+        /*! \brief Gets the best instruction set supported by the processor, detected once.
+        *
+            The vector kernels are only compiled by GCC and Clang for x86 processors, other targets use the scalar one.
+        */
+        inline Level level() noexcept
+        {
+#ifdef CONFLICTS_SIMD_X86
+            static const Level detected = []
+                {
+                    __builtin_cpu_init();
+                    if (__builtin_cpu_supports("avx2"))
+                        return Level::Avx2;
+                    return __builtin_cpu_supports("sse2") ? Level::Sse : Level::Scalar;
+                }();
+            return detected;
+#else
+            return Level::Scalar;
+#endif
+        }
+
+        namespace detail
+        {
+            // When Any is set, the kernels stop at the first common value and return 1.
+            // Otherwise, they return the number of common values and write them in out if not null.
+
+            template <bool Any>
+            size_t merge(const uint32_t* a, size_t na, const uint32_t* b, size_t nb, uint32_t* out) noexcept
+            {
+                size_t i{ 0 }, j{ 0 }, count{ 0 };
+                while (i < na && j < nb)
+                {
+                    if (a[i] < b[j])
+                        ++i;
+                    else if (b[j] < a[i])
+                        ++j;
+                    else
+                    {
+                        if constexpr (Any)
+                            return 1;
+                        if (out)
+                            out[count] = a[i];
+                        ++count;
+                        ++i;
+                        ++j;
+                    }
+                }
+                return count;
+            }
+
+            // each value of the short list is searched by exponential then binary search in the remaining part of the long one
+            template <bool Any>
+            size_t gallop(const uint32_t* a, size_t na, const uint32_t* b, size_t nb, uint32_t* out) noexcept
+            {
+                size_t j{ 0 }, count{ 0 };
+                for (size_t i = 0; i < na && j < nb; ++i)
+                {
+                    size_t step{ 1 };
+                    while (j + step < nb && b[j + step] < a[i])
+                        step <<= 1;
+                    const uint32_t* found = std::lower_bound(b + j + step / 2, b + std::min(nb, j + step + 1), a[i]);
+                    j = static_cast<size_t>(found - b);
+                    if (j < nb && b[j] == a[i])
+                    {
+                        if constexpr (Any)
+                            return 1;
+                        if (out)
+                            out[count] = a[i];
+                        ++count;
+                        ++j;
+                    }
+                }
+                return count;
+            }
+
+#ifdef CONFLICTS_SIMD_X86
+            template <bool Any>
+            __attribute__((target("sse2"))) size_t sse(const uint32_t* a, size_t na, const uint32_t* b, size_t nb, uint32_t* out) noexcept
+            {
+                size_t i{ 0 }, j{ 0 }, count{ 0 };
+                while (i + 4 <= na && j + 4 <= nb)
+                {
+                    // all the pairs of the 2 blocks are compared by rotating the second one
+                    __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+                    __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + j));
+                    __m128i eq = _mm_or_si128(
+                        _mm_or_si128(_mm_cmpeq_epi32(va, vb), _mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, _MM_SHUFFLE(0, 3, 2, 1)))),
+                        _mm_or_si128(_mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, _MM_SHUFFLE(1, 0, 3, 2))), _mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, _MM_SHUFFLE(2, 1, 0, 3)))));
+                    unsigned mask = static_cast<unsigned>(_mm_movemask_ps(_mm_castsi128_ps(eq)));
+                    if (mask)
+                    {
+                        if constexpr (Any)
+                            return 1;
+                        for (; mask; mask &= mask - 1)
+                        {
+                            if (out)
+                                out[count] = a[i + __builtin_ctz(mask)];
+                            ++count;
+                        }
+                    }
+                    uint32_t amax = a[i + 3], bmax = b[j + 3];
+                    if (amax <= bmax)
+                        i += 4;
+                    if (bmax <= amax)
+                        j += 4;
+                }
+                return count + merge<Any>(a + i, na - i, b + j, nb - j, out ? out + count : nullptr);
+            }
+
+            template <bool Any>
+            __attribute__((target("avx2"))) size_t avx2(const uint32_t* a, size_t na, const uint32_t* b, size_t nb, uint32_t* out) noexcept
+            {
+                size_t i{ 0 }, j{ 0 }, count{ 0 };
+                while (i + 8 <= na && j + 8 <= nb)
+                {
+                    // all the pairs are compared against the rotations of the second block, computed independently of each other
+                    __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+                    __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + j));
+                    __m256i eq1 = _mm256_or_si256(
+                        _mm256_cmpeq_epi32(va, vb),
+                        _mm256_cmpeq_epi32(va, _mm256_permutevar8x32_epi32(vb, _mm256_setr_epi32(1, 2, 3, 4, 5, 6, 7, 0))));
+                    __m256i eq2 = _mm256_or_si256(
+                        _mm256_cmpeq_epi32(va, _mm256_permutevar8x32_epi32(vb, _mm256_setr_epi32(2, 3, 4, 5, 6, 7, 0, 1))),
+                        _mm256_cmpeq_epi32(va, _mm256_permutevar8x32_epi32(vb, _mm256_setr_epi32(3, 4, 5, 6, 7, 0, 1, 2))));
+                    __m256i eq3 = _mm256_or_si256(
+                        _mm256_cmpeq_epi32(va, _mm256_permutevar8x32_epi32(vb, _mm256_setr_epi32(4, 5, 6, 7, 0, 1, 2, 3))),
+                        _mm256_cmpeq_epi32(va, _mm256_permutevar8x32_epi32(vb, _mm256_setr_epi32(5, 6, 7, 0, 1, 2, 3, 4))));
+                    __m256i eq4 = _mm256_or_si256(
+                        _mm256_cmpeq_epi32(va, _mm256_permutevar8x32_epi32(vb, _mm256_setr_epi32(6, 7, 0, 1, 2, 3, 4, 5))),
+                        _mm256_cmpeq_epi32(va, _mm256_permutevar8x32_epi32(vb, _mm256_setr_epi32(7, 0, 1, 2, 3, 4, 5, 6))));
+                    __m256i eq = _mm256_or_si256(_mm256_or_si256(eq1, eq2), _mm256_or_si256(eq3, eq4));
+                    unsigned mask = static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(eq)));
+                    if (mask)
+                    {
+                        if constexpr (Any)
+                            return 1;
+                        for (; mask; mask &= mask - 1)
+                        {
+                            if (out)
+                                out[count] = a[i + __builtin_ctz(mask)];
+                            ++count;
+                        }
+                    }
+                    uint32_t amax = a[i + 7], bmax = b[j + 7];
+                    if (amax <= bmax)
+                        i += 8;
+                    if (bmax <= amax)
+                        j += 8;
+                }
+                return count + sse<Any>(a + i, na - i, b + j, nb - j, out ? out + count : nullptr);
+            }
+
+            __attribute__((target("sse2"))) inline size_t and_not_sse(uint64_t* bits, const uint64_t* mask, size_t words) noexcept
+            {
+                size_t i{ 0 };
+                for (; i + 2 <= words; i += 2)
+                {
+                    __m128i vbits = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bits + i));
+                    __m128i vmask = _mm_loadu_si128(reinterpret_cast<const __m128i*>(mask + i));
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(bits + i), _mm_andnot_si128(vmask, vbits));
+                }
+                return i;
+            }
+
+            __attribute__((target("avx2"))) inline size_t and_not_avx2(uint64_t* bits, const uint64_t* mask, size_t words) noexcept
+            {
+                size_t i{ 0 };
+                for (; i + 4 <= words; i += 4)
+                {
+                    __m256i vbits = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(bits + i));
+                    __m256i vmask = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(mask + i));
+                    _mm256_storeu_si256(reinterpret_cast<__m256i*>(bits + i), _mm256_andnot_si256(vmask, vbits));
+                }
+                return i;
+            }
+#endif
+
+            template <bool Any>
+            size_t intersect(const uint32_t* a, size_t na, const uint32_t* b, size_t nb, uint32_t* out, Level level) noexcept
+            {
+                if (na > nb)
+                {
+                    std::swap(a, b);
+                    std::swap(na, nb);
+                }
+                // galloping is faster than any block comparison when the lengths are very different
+                if (na * 32 < nb)
+                    return gallop<Any>(a, na, b, nb, out);
+#ifdef CONFLICTS_SIMD_X86
+                if (level == Level::Avx2 && Simd::level() == Level::Avx2)
+                    return avx2<Any>(a, na, b, nb, out);
+                if (level != Level::Scalar && Simd::level() != Level::Scalar)
+                    return sse<Any>(a, na, b, nb, out);
+#else
+                (void)level;
+#endif
+                return merge<Any>(a, na, b, nb, out);
+            }
+        }
+
+        /*! \brief Intersects 2 sorted lists of unique identifiers.
+        *   \param a,na the first list and its length
+        *   \param b,nb the second list and its length
+        *   \param out receives the common identifiers in increasing order, must hold min(na, nb) values, may be null to count only
+        *   \param level the instruction set to use, lowered to the best one supported by the processor
+        *   \return the number of common identifiers
+        */
+        inline size_t intersect(const uint32_t* a, size_t na, const uint32_t* b, size_t nb, uint32_t* out, Level level = Simd::level()) noexcept
+        {
+            return detail::intersect<false>(a, na, b, nb, out, level);
+        }
+
+        /*! \brief Checks if 2 sorted lists of unique identifiers have a common value.
+        *   \sa intersect()
+        */
+        inline bool intersects(const uint32_t* a, size_t na, const uint32_t* b, size_t nb, Level level = Simd::level()) noexcept
+        {
+            return detail::intersect<true>(a, na, b, nb, nullptr, level) > 0;
+        }
+
+        /*! \brief Clears the bits of a bitset that are set in a mask.
+        *   \param bits the bitset to update, as 64 bits words
+        *   \param mask the bits to clear, of the same length
+        *   \param words the number of words of both bitsets
+        *   \param level the instruction set to use, lowered to the best one supported by the processor
+        */
+        inline void and_not(uint64_t* bits, const uint64_t* mask, size_t words, Level level = Simd::level()) noexcept
+        {
+            size_t i{ 0 };
+#ifdef CONFLICTS_SIMD_X86
+            if (level == Level::Avx2 && Simd::level() == Level::Avx2)
+                i = detail::and_not_avx2(bits, mask, words);
+            else if (level != Level::Scalar && Simd::level() != Level::Scalar)
+                i = detail::and_not_sse(bits, mask, words);
+#else
+            (void)level;
+#endif
+            for (; i < words; ++i)
+                bits[i] &= ~mask[i];
+        }
+
+    }
+}
@@ -0,0 +1,189 @@
+#pragma once
+
+/*! \file conflicts_wheel.hpp
+*	\brief Implements the template class TimerWheel used by the expiring storage engine.
+*   \author Christophe COUAILLET
+*/
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#if defined(_MSC_VER) && defined(_M_X64)
+#include <intrin.h>
+#endif
+
+namespace Conflicts
+{
+
+    /*! \brief Gets the position of the lowest bit set in a non-zero value. */
+    inline unsigned lowest_bit(uint64_t value) noexcept
+    {
+#if defined(__GNUC__) || defined(__clang__)
+        return static_cast<unsigned>(__builtin_ctzll(value));
+#elif defined(_MSC_VER) && defined(_M_X64)
+        unsigned long index;
+        _BitScanForward64(&index, value);
+        return static_cast<unsigned>(index);
+#else
+        unsigned index{ 0 };
+        while ((value & 1) == 0)
+        {
+            value >>= 1;
+            ++index;
+        }
+        return index;
+#endif
+    }
+
+    /*! \brief Class TimerWheel implements a hierarchical timing wheel, that releases values once their deadline is reached.
+    *
+        Deadlines are 64 bits tick counts. The wheel has 11 levels of 64 slots, a level covering 64 times the ticks of the previous one,
+        so that any deadline is held without overflow list. A value is put in the level of the highest 6 bits group where its deadline
+        differs from the current tick, and is moved down a level each time the current tick reaches its slot, thus at most 10 times.
+        Advancing jumps from an occupied slot to the next one, found with a bitmask per level, so that idle ticks cost nothing.
+        Scheduling is performed in constant time, and each release in constant amortized time.
+    */
+    template <typename V>
+    class TimerWheel
+    {
+    public:
+        /*! \brief Gets the current tick, the last one advanced to. */
+        uint64_t now() const noexcept { return m_now; }
+
+        /*! \brief Checks if no value is pending. */
+        bool empty() const noexcept { return size() == 0; }
+
+        /*! \brief Gets the number of pending values. */
+        size_t size() const noexcept { return m_size + m_due.size(); }
+
+        /*! \brief Gets a tick no later than the earliest pending deadline, the maximum tick if no value is pending. */
+        uint64_t earliest() const noexcept
+        {
+            if (!m_due.empty())
+                return 0;
+            return next_event();
+        }
+
+        /*! \brief Removes all the pending values, the current tick being kept. */
+        void clear() noexcept
+        {
+            for (auto& level : m_slots)
+                for (auto& slot : level)
+                    slot.clear();
+            m_occupied.fill(0);
+            m_due.clear();
+            m_size = 0;
+        }
+
+        /*! \brief Schedules the release of a value.
+        *   \param deadline the tick from which the value is released, a past one releasing it on the next advance
+        *   \param value the value to release
+        */
+        void schedule(uint64_t deadline, V value)
+        {
+            if (deadline <= m_now)
+                m_due.push_back(Entry{ deadline, std::move(value) });
+            else
+                place(Entry{ deadline, std::move(value) });
+        }
+
+        /*! \brief Advances the current tick and releases the values whose deadline is reached.
+        *   \param tick the new current tick, ignored if it is before the current one
+        *   \param f the function called with the deadline and the value of each released value, by increasing deadline
+        *   except for the values scheduled in the past that come first
+        */
+        template <typename F>
+        void advance(uint64_t tick, F&& f)
+        {
+            if (!m_due.empty())
+            {
+                std::vector<Entry> due{};
+                due.swap(m_due);
+                for (auto& entry : due)
+                    f(entry.deadline, entry.value);
+            }
+            while (tick > m_now)
+            {
+                uint64_t next = next_event();
+                if (next > tick)
+                    break;
+                m_now = next;
+                // the slots reached are emptied from the highest level, their values being released or moved down
+                for (size_t level = Levels; level-- > 0;)
+                {
+                    unsigned slot = chunk(m_now, level);
+                    if ((m_occupied[level] & (uint64_t{ 1 } << slot)) == 0)
+                        continue;
+                    std::vector<Entry> entries{};
+                    entries.swap(m_slots[level][slot]);
+                    m_occupied[level] &= ~(uint64_t{ 1 } << slot);
+                    m_size -= entries.size();
+                    for (auto& entry : entries)
+                        if (entry.deadline <= m_now)
+                            f(entry.deadline, entry.value);
+                        else
+                            place(std::move(entry));
+                }
+            }
+            if (tick > m_now)
+                m_now = tick;
+        }
+
+    private:
+        static constexpr unsigned Bits = 6;
+        static constexpr size_t Slots = size_t{ 1 } << Bits;
+        static constexpr size_t Levels = (64 + Bits - 1) / Bits;
+
+        struct Entry
+        {
+            uint64_t deadline;
+            V value;
+        };
+
+        std::array<std::array<std::vector<Entry>, Slots>, Levels> m_slots{};
+        std::array<uint64_t, Levels> m_occupied{};     // slots holding values, a bit per slot
+        std::vector<Entry> m_due{};                     // values scheduled in the past
+        uint64_t m_now{ 0 };
+        size_t m_size{ 0 };                             // values held in the slots
+
+        static unsigned chunk(uint64_t tick, size_t level) noexcept { return static_cast<unsigned>((tick >> (Bits * level)) & (Slots - 1)); }
+
+        // the deadline must be after the current tick
+        void place(Entry&& entry)
+        {
+            uint64_t diff = entry.deadline ^ m_now;
+            size_t level{ 0 };
+            while (level + 1 < Levels && (diff >> (Bits * (level + 1))) != 0)
+                ++level;
+            unsigned slot = chunk(entry.deadline, level);
+            m_slots[level][slot].push_back(std::move(entry));
+            m_occupied[level] |= uint64_t{ 1 } << slot;
+            ++m_size;
+        }
+
+        // first tick after the current one where an occupied slot is reached
+        uint64_t next_event() const noexcept
+        {
+            uint64_t result = std::numeric_limits<uint64_t>::max();
+            if (m_size == 0)
+                return result;
+            for (size_t level = 0; level < Levels; ++level)
+            {
+                // the values of a level share the upper bits of the current tick, their slots are after its own one
+                uint64_t mask = m_occupied[level] & ~((uint64_t{ 2 } << chunk(m_now, level)) - 1);
+                if (mask == 0)
+                    continue;
+                uint64_t upper = level + 1 < Levels ? (m_now >> (Bits * (level + 1))) << (Bits * (level + 1)) : 0;
+                uint64_t tick = upper | (uint64_t{ lowest_bit(mask) } << (Bits * level));
+                if (tick < result)
+                    result = tick;
+            }
+            return result;
+        }
+    };
+
+}
@@ -0,0 +1,920 @@
+#include <gtest/gtest.h>
+#include <conflicts.hpp>
+#include <conflicts_frozen.hpp>
+#include <conflicts_resolver.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <iterator>
+#include <limits>
+#include <map>
+#include <memory>
+#include <random>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Differential harness: random sequences of mutations are generated against a naive reference model,
+// then replayed on every storage engine under test. All query results are compared after each step,
+// and a second, unchecked replay measures the throughput of each engine.
+
+namespace
+{
+	constexpr int Universe = 16;			// objects are the integers [0, Universe)
+	constexpr size_t Steps = 600;			// mutations per sequence
+	const unsigned Seeds[] = { 1, 7, 42, 2024 };
+
+	/*	Naive model of the conflicts semantics: a set of canonical pairs, scanned on each query, and
+		a union-find rebuilt on each cascading pair check, or a walk of the paths within a bounded depth.
+		It is slow but obviously correct. */
+	class Reference
+	{
+	public:
+		explicit Reference(Conflicts::Depth depth) : m_cascading(depth.hops == Conflicts::Depth::unbounded), m_depth(depth.hops) {}
+
+		void clear() { m_edges.clear(); m_weights.clear(); }
+		bool empty() const { return m_edges.empty(); }
+		size_t size() const { return m_edges.size(); }
+		void add(int a, int b) { add(a, b, Conflicts::DefaultWeight); }
+		void add(int a, int b, Conflicts::Weight weight)
+		{
+			m_edges.insert(canonical(a, b));
+			m_weights[canonical(a, b)] = weight;
+		}
+		void remove(int a, int b) { m_edges.erase(canonical(a, b)); }
+		void remove(int a)
+		{
+			for (auto itr = m_edges.begin(); itr != m_edges.end();)
+				itr = (itr->first == a || itr->second == a) ? m_edges.erase(itr) : std::next(itr);
+		}
+		Conflicts::Weight weight(int a, int b) const { return m_weights.at(canonical(a, b)); }
+		void set(const std::unordered_multimap<int, int>& pairs)
+		{
+			clear();
+			merge(pairs);
+		}
+		void merge(const std::unordered_multimap<int, int>& pairs)
+		{
+			for (auto& edge : pairs)
+				add(edge.first, edge.second);
+		}
+		bool linked(int a, int b) const { return m_edges.count(canonical(a, b)) > 0; }
+		bool in_conflict(int a) const { return !conflicts(a).empty(); }
+		bool in_conflict(int a, int b) const
+		{
+			if (!m_cascading)
+			{
+				if (m_depth == 1)
+					return linked(a, b);
+				auto objects = within(a, m_depth);
+				return std::find(objects.begin(), objects.end(), b) != objects.end();
+			}
+			// while cascading, an object in conflict with another one is reported in conflict with itself
+			if (a == b)
+				return in_conflict(a);
+			std::vector<int> parent(Universe);
+			for (int i = 0; i < Universe; ++i)
+				parent[i] = i;
+			auto root = [&parent](int x) { while (parent[x] != x) x = parent[x]; return x; };
+			for (auto& edge : m_edges)
+				parent[root(edge.first)] = root(edge.second);
+			return root(a) == root(b);
+		}
+		std::vector<int> conflicts(int a) const
+		{
+			std::vector<int> result;
+			for (auto& edge : m_edges)
+			{
+				if (edge.first == a)
+					result.push_back(edge.second);
+				else if (edge.second == a)
+					result.push_back(edge.first);
+			}
+			std::sort(result.begin(), result.end());
+			return result;
+		}
+		std::vector<int> all_conflicts(int a) const
+		{
+			if (!m_cascading)
+				return within(a, m_depth);
+			// a cascading graph is a forest, so a is reachable from itself only when it has a conflict
+			std::set<int> seen;
+			std::vector<int> stack{ a };
+			while (!stack.empty())
+			{
+				int cur = stack.back();
+				stack.pop_back();
+				for (int next : conflicts(cur))
+					if (seen.insert(next).second)
+						stack.push_back(next);
+			}
+			seen.erase(a);
+			return { seen.begin(), seen.end() };
+		}
+		// objects linked by relationships of at least min_weight, within the depth or whatever the number of relationships when cascading
+		std::vector<int> conflicts(int a, Conflicts::Weight min_weight) const
+		{
+			std::vector<int> result;
+			for (int con : conflicts(a))
+				if (weight(a, con) >= min_weight)
+					result.push_back(con);
+			return result;
+		}
+		bool in_conflict(int a, int b, Conflicts::Weight min_weight) const
+		{
+			if (a == b)
+				return m_cascading && !conflicts(a, min_weight).empty();
+			auto objects = within(a, m_cascading ? Universe : m_depth, min_weight);
+			return std::find(objects.begin(), objects.end(), b) != objects.end();
+		}
+		std::vector<int> within(int a, size_t hops, Conflicts::Weight min_weight = std::numeric_limits<Conflicts::Weight>::lowest()) const
+		{
+			// level by level, each object being expanded once
+			std::set<int> seen{ a };
+			std::vector<int> level{ a };
+			for (size_t hop = 0; hop < hops && !level.empty(); ++hop)
+			{
+				std::vector<int> next;
+				for (int cur : level)
+					for (int con : conflicts(cur, min_weight))
+						if (seen.insert(con).second)
+							next.push_back(con);
+				level.swap(next);
+			}
+			seen.erase(a);
+			return { seen.begin(), seen.end() };
+		}
+		std::vector<std::pair<int, int>> pairs() const { return { m_edges.begin(), m_edges.end() }; }
+		std::set<std::set<int>> components() const
+		{
+			std::set<std::set<int>> result;
+			std::set<int> seen;
+			for (int a = 0; a < Universe; ++a)
+			{
+				if (seen.count(a) || !in_conflict(a))
+					continue;
+				std::vector<int> stack{ a };
+				std::set<int> members{ a };
+				while (!stack.empty())
+				{
+					int cur = stack.back();
+					stack.pop_back();
+					for (int next : conflicts(cur))
+						if (members.insert(next).second)
+							stack.push_back(next);
+				}
+				seen.insert(members.begin(), members.end());
+				result.insert(members);
+			}
+			return result;
+		}
+		std::vector<size_t> component_sizes() const
+		{
+			std::vector<size_t> result;
+			for (auto& members : components())
+				result.push_back(members.size());
+			std::sort(result.rbegin(), result.rend());
+			return result;
+		}
+
+	private:
+		static std::pair<int, int> canonical(int a, int b) { return a < b ? std::make_pair(a, b) : std::make_pair(b, a); }
+
+		bool m_cascading;
+		size_t m_depth;
+		std::set<std::pair<int, int>> m_edges;
+		std::map<std::pair<int, int>, Conflicts::Weight> m_weights;
+	};
+
+	enum class OpKind { Add, RemovePair, RemoveObject, Set, Merge, Clear };
+
+	struct Op
+	{
+		OpKind kind;
+		int a{ 0 };
+		int b{ 0 };
+		Conflicts::Weight weight{ Conflicts::DefaultWeight };
+		std::unordered_multimap<int, int> pairs{};
+	};
+
+	// Checks if the subject keeps the weights of the relationships, the reference always does.
+	template <typename C>
+	struct Weighted : std::bool_constant<Conflicts::is_weighted_v<typename C::storage_type, int>> {};
+
+	template <>
+	struct Weighted<Reference> : std::true_type {};
+
+	// Draws a pair of objects that may legally be added to the model, if any is found.
+	bool draw_addable(std::mt19937& rng, const Reference& model, int& a, int& b)
+	{
+		std::uniform_int_distribution<int> object(0, Universe - 1);
+		for (int attempt = 0; attempt < 32; ++attempt)
+		{
+			a = object(rng);
+			b = object(rng);
+			if (a != b && !model.in_conflict(a, b))
+				return true;
+		}
+		return false;
+	}
+
+	// Builds a random, valid sequence of mutations; only operations allowed by the class contract are generated.
+	std::vector<Op> generate(unsigned seed, Conflicts::Depth depth)
+	{
+		std::mt19937 rng(seed);
+		std::uniform_int_distribution<int> kind(0, 99);
+		Reference model(depth);
+		std::vector<Op> ops;
+		while (ops.size() < Steps)
+		{
+			int k = kind(rng);
+			Op op{ OpKind::Add };
+			if (k < 55)
+			{
+				if (!draw_addable(rng, model, op.a, op.b))
+					continue;
+				// derived from the objects, so that the sequence of random numbers is unchanged
+				op.weight = 1 + (op.a + op.b) % 3;
+				model.add(op.a, op.b, op.weight);
+			}
+			else if (k < 75)
+			{
+				auto pairs = model.pairs();
+				if (pairs.empty())
+					continue;
+				auto& edge = pairs[std::uniform_int_distribution<size_t>(0, pairs.size() - 1)(rng)];
+				op.kind = OpKind::RemovePair;
+				// the pair is given in a random order, the relationship is bidirectional
+				op.a = (rng() & 1) ? edge.first : edge.second;
+				op.b = op.a == edge.first ? edge.second : edge.first;
+				model.remove(op.a, op.b);
+			}
+			else if (k < 87)
+			{
+				op.a = std::uniform_int_distribution<int>(0, Universe - 1)(rng);
+				if (!model.in_conflict(op.a))
+					continue;
+				op.kind = OpKind::RemoveObject;
+				model.remove(op.a);
+			}
+			else if (k < 97)
+			{
+				op.kind = k < 92 ? OpKind::Merge : OpKind::Set;
+				Reference batch = op.kind == OpKind::Merge ? model : Reference(depth);
+				int count = std::uniform_int_distribution<int>(1, Universe / 2)(rng);
+				for (int i = 0; i < count; ++i)
+				{
+					int a, b;
+					if (!draw_addable(rng, batch, a, b))
+						break;
+					batch.add(a, b);
+					op.pairs.emplace(a, b);
+				}
+				model = batch;
+			}
+			else
+			{
+				op.kind = OpKind::Clear;
+				model.clear();
+			}
+			ops.push_back(std::move(op));
+		}
+		return ops;
+	}
+
+	template <typename C>
+	void perform(C& subject, const Op& op)
+	{
+		switch (op.kind)
+		{
+		case OpKind::Add:
+			if constexpr (Weighted<C>::value)
+				subject.add(op.a, op.b, op.weight);
+			else
+				subject.add(op.a, op.b);
+			break;
+		case OpKind::RemovePair: subject.remove(op.a, op.b); break;
+		case OpKind::RemoveObject: subject.remove(op.a); break;
+		case OpKind::Set: subject.set(op.pairs); break;
+		case OpKind::Merge: subject.merge(op.pairs); break;
+		case OpKind::Clear: subject.clear(); break;
+		}
+	}
+
+	std::vector<int> sorted(std::vector<int> values)
+	{
+		std::sort(values.begin(), values.end());
+		return values;
+	}
+
+	template <typename C>
+	void compare(const C& subject, const Reference& model, size_t step)
+	{
+		SCOPED_TRACE("step " + std::to_string(step));
+		ASSERT_EQ(subject.size(), model.size());
+		ASSERT_EQ(subject.empty(), model.empty());
+		std::vector<std::pair<int, int>> pairs;
+		for (auto& edge : subject.get())
+			pairs.push_back(std::minmax(edge.first, edge.second));
+		std::sort(pairs.begin(), pairs.end());
+		ASSERT_EQ(pairs, model.pairs());
+		std::vector<std::vector<int>> direct(Universe);
+		for (int a = 0; a < Universe; ++a)
+			direct[a] = model.conflicts(a);
+		std::vector<size_t> degrees;
+		for (int a = 0; a < Universe; ++a)
+			if (!direct[a].empty())
+				degrees.push_back(direct[a].size());
+		std::sort(degrees.rbegin(), degrees.rend());
+		degrees.resize(std::min<size_t>(degrees.size(), 5));
+		std::vector<size_t> ranked;
+		for (auto& item : subject.top_conflicted(5))
+		{
+			ASSERT_EQ(item.second, direct[item.first].size()) << "object " << item.first;
+			ranked.push_back(item.second);
+		}
+		ASSERT_EQ(ranked, degrees);
+		auto sizes = model.component_sizes();
+		sizes.resize(std::min<size_t>(sizes.size(), 5));
+		ASSERT_EQ(subject.largest_components(5), sizes);
+		auto list = subject.components();
+		ASSERT_EQ(list.offsets.size(), list.size() + 1);
+		ASSERT_EQ(list.offsets.back(), list.members.size());
+		auto labels = subject.component_labels();
+		ASSERT_EQ(labels.size(), list.members.size());
+		std::set<std::set<int>> groups;
+		for (size_t i = 0; i < list.size(); ++i)
+		{
+			groups.emplace(list.members.begin() + list.offsets[i], list.members.begin() + list.offsets[i + 1]);
+			for (size_t pos = list.offsets[i]; pos < list.offsets[i + 1]; ++pos)
+				ASSERT_EQ(labels.at(list.members[pos]), list.labels[i]) << "object " << list.members[pos];
+		}
+		ASSERT_EQ(groups, model.components());
+		for (int a = 0; a < Universe; ++a)
+		{
+			size_t label = subject.component_id(a);
+			ASSERT_EQ(label == static_cast<size_t>(-1), !model.in_conflict(a)) << "object " << a;
+			if (label != static_cast<size_t>(-1))
+			{
+				ASSERT_EQ(labels.at(a), label) << "object " << a;
+			}
+		}
+		std::vector<int> everyone(Universe);
+		for (int a = 0; a < Universe; ++a)
+			everyone[a] = a;
+		for (int a = 0; a < Universe; ++a)
+		{
+			ASSERT_EQ(subject.in_conflict(a), model.in_conflict(a)) << "object " << a;
+			std::vector<int> set{ a, (a * 7 + 3) % Universe }, compatible;
+			for (int b = 0; b < Universe; ++b)
+				if (!model.in_conflict(set[0], b) && !model.in_conflict(set[1], b))
+					compatible.push_back(b);
+			ASSERT_EQ(subject.compatible_with(set, everyone), compatible) << "objects " << set[0] << ", " << set[1];
+			ASSERT_EQ(sorted(subject.conflicts(a)), model.conflicts(a)) << "object " << a;
+			ASSERT_EQ(sorted(subject.all_conflicts(a)), model.all_conflicts(a)) << "object " << a;
+			ASSERT_EQ(sorted(subject.conflicts_within(a, 3)), model.within(a, 3)) << "object " << a;
+			if constexpr (Weighted<C>::value)
+			{
+				ASSERT_EQ(sorted(subject.conflicts(a, 2)), model.conflicts(a, 2)) << "object " << a;
+				for (int b = 0; b < Universe; ++b)
+					ASSERT_EQ(subject.in_conflict(a, b, 2), model.in_conflict(a, b, 2)) << "objects " << a << ", " << b;
+			}
+			for (int b = 0; b < Universe; ++b)
+			{
+				ASSERT_EQ(subject.in_conflict(a, b), model.in_conflict(a, b)) << "objects " << a << ", " << b;
+				std::vector<int> common;
+				std::set_intersection(direct[a].begin(), direct[a].end(), direct[b].begin(), direct[b].end(), std::back_inserter(common));
+				ASSERT_EQ(sorted(subject.common_conflicts(a, b)), common) << "objects " << a << ", " << b;
+				ASSERT_EQ(subject.shares_conflict(a, b), !common.empty()) << "objects " << a << ", " << b;
+				double similarity = direct[a].empty() || direct[b].empty() ? 0.0
+					: static_cast<double>(common.size()) / static_cast<double>(direct[a].size() + direct[b].size() - common.size());
+				ASSERT_DOUBLE_EQ(subject.conflict_similarity(a, b), similarity) << "objects " << a << ", " << b;
+			}
+		}
+	}
+
+	// Replays the sequence without any check, followed by a full round of queries, and returns the elapsed seconds.
+	template <typename C>
+	double replay(bool cascading, const std::vector<Op>& ops)
+	{
+		C subject{ cascading };
+		size_t hits{ 0 };
+		auto start = std::chrono::steady_clock::now();
+		for (auto& op : ops)
+		{
+			perform(subject, op);
+			for (int a = 0; a < Universe; ++a)
+				for (int b = a + 1; b < Universe; ++b)
+					hits += subject.in_conflict(a, b);
+		}
+		std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+		::testing::Test::RecordProperty("checksum", std::to_string(hits));
+		return elapsed.count();
+	}
+}
+
+/*	Runs the mutations on a Conflicts instance and answers the queries from a snapshot taken after each of them,
+	so that the throughput measured includes the snapshots. */
+template <Conflicts::Ordering O>
+class Frozen
+{
+public:
+	explicit Frozen(bool cascading) : m_source(cascading) {}
+	explicit Frozen(Conflicts::Depth depth) : m_source(depth) {}
+
+	using storage_type = Conflicts::Conflicts<int>::storage_type;
+
+	void clear() { m_source.clear(); refresh(); }
+	void add(int a, int b) { m_source.add(a, b); refresh(); }
+	void add(int a, int b, Conflicts::Weight weight) { m_source.add(a, b, weight); refresh(); }
+	void remove(int a, int b) { m_source.remove(a, b); refresh(); }
+	void remove(int a) { m_source.remove(a); refresh(); }
+	void set(const std::unordered_multimap<int, int>& pairs) { m_source.set(pairs); refresh(); }
+	void merge(const std::unordered_multimap<int, int>& pairs) { m_source.merge(pairs); refresh(); }
+
+	bool empty() const { return m_frozen.empty(); }
+	size_t size() const { return m_frozen.size(); }
+	bool in_conflict(int a) const { return m_frozen.in_conflict(a); }
+	bool in_conflict(int a, int b) const { return m_frozen.in_conflict(a, b); }
+	std::vector<int> conflicts(int a) const { return m_frozen.conflicts(a); }
+	std::vector<int> conflicts(int a, Conflicts::Weight min_weight) const { return m_frozen.conflicts(a, min_weight); }
+	bool in_conflict(int a, int b, Conflicts::Weight min_weight) const { return m_frozen.in_conflict(a, b, min_weight); }
+	std::vector<int> all_conflicts(int a) const { return m_frozen.all_conflicts(a); }
+	std::vector<int> conflicts_within(int a, size_t hops) const { return m_frozen.conflicts_within(a, hops); }
+	std::vector<int> common_conflicts(int a, int b) const { return m_frozen.common_conflicts(a, b); }
+	bool shares_conflict(int a, int b) const { return m_frozen.shares_conflict(a, b); }
+	double conflict_similarity(int a, int b) const { return m_frozen.conflict_similarity(a, b); }
+	std::vector<std::pair<int, size_t>> top_conflicted(size_t k) const { return m_source.top_conflicted(k); }
+	std::vector<size_t> largest_components(size_t k) const { return m_source.largest_components(k); }
+	Conflicts::ComponentList<int> components() const { return m_source.components(); }
+	size_t component_id(int a) const { return m_source.component_id(a); }
+	std::unordered_map<int, size_t> component_labels() const { return m_source.component_labels(); }
+	std::vector<int> compatible_with(const std::vector<int>& set, const std::vector<int>& candidates) const { return m_frozen.compatible_with(set, candidates); }
+	std::unordered_multimap<int, int> get() const
+	{
+		std::unordered_multimap<int, int> result;
+		for (uint32_t id = 0; id < m_frozen.objects(); ++id)
+			for (uint32_t con : m_frozen.neighbours(id))
+				if (id < con)
+					result.emplace(m_frozen.object(id), m_frozen.object(con));
+		return result;
+	}
+
+private:
+	Conflicts::Conflicts<int> m_source;
+	Conflicts::FrozenConflicts<int> m_frozen{};
+
+	void refresh() { m_frozen = m_source.freeze(O); }
+};
+
+template <typename C>
+class ConflictsFuzz : public ::testing::Test
+{
+protected:
+	void run(Conflicts::Depth depth)
+	{
+		for (unsigned seed : Seeds)
+		{
+			SCOPED_TRACE("seed " + std::to_string(seed));
+			auto ops = generate(seed, depth);
+			Reference model(depth);
+			C subject{ depth };
+			for (size_t step = 0; step < ops.size(); ++step)
+			{
+				perform(model, ops[step]);
+				perform(subject, ops[step]);
+				compare(subject, model, step);
+				if (HasFatalFailure())
+					return;
+			}
+		}
+	}
+
+	void measure(bool cascading)
+	{
+		double seconds{ 0 };
+		size_t count{ 0 };
+		for (unsigned seed : Seeds)
+		{
+			auto ops = generate(seed, { cascading ? Conflicts::Depth::unbounded : 1 });
+			seconds += replay<C>(cascading, ops);
+			count += ops.size();
+		}
+		double throughput = seconds > 0 ? count / seconds : 0;
+		RecordProperty(cascading ? "cascading_ops_per_second" : "direct_ops_per_second", std::to_string(static_cast<long long>(throughput)));
+		std::cout << "[ throughput ] " << ::testing::UnitTest::GetInstance()->current_test_info()->type_param()
+			<< (cascading ? " cascading: " : " direct: ") << static_cast<long long>(throughput) << " ops/s" << std::endl;
+	}
+};
+
+using Engines = ::testing::Types<
+	Conflicts::Conflicts<int, Conflicts::RequirementsEngine>,
+	Conflicts::Conflicts<int, Conflicts::AdjacencyEngine>,
+	Conflicts::Conflicts<int, Conflicts::FilteredEngine<Conflicts::AdjacencyEngine>>,
+	Conflicts::Conflicts<int, Conflicts::RankedEngine<Conflicts::AdjacencyEngine>>,
+	Conflicts::Conflicts<int, Conflicts::ExpiringEngine<Conflicts::RankedEngine<Conflicts::AdjacencyEngine>>>,
+	Conflicts::Conflicts<int, Conflicts::GroupedEngine<Conflicts::AdjacencyEngine>>,
+	Conflicts::Conflicts<int, Conflicts::IntervalEngine<Conflicts::AdjacencyEngine>>,
+	Conflicts::Conflicts<int, Conflicts::AdjacencyEngine, std::hash<int>, std::equal_to<int>, Conflicts::TrustedValidation>,
+	Frozen<Conflicts::Ordering::None>,
+	Frozen<Conflicts::Ordering::ReverseCuthillMcKee>>;
+TYPED_TEST_SUITE(ConflictsFuzz, Engines);
+
+TYPED_TEST(ConflictsFuzz, Direct)
+{
+	this->run({ 1 });
+}
+
+TYPED_TEST(ConflictsFuzz, Cascading)
+{
+	this->run({ Conflicts::Depth::unbounded });
+}
+
+TYPED_TEST(ConflictsFuzz, Bounded)
+{
+	this->run({ 2 });
+}
+
+TYPED_TEST(ConflictsFuzz, Throughput)
+{
+	this->measure(false);
+	this->measure(true);
+}
+
+namespace
+{
+	// Builds random relationships between edges / 4 objects, the number of edges being read from CONFLICTS_BENCH_EDGES.
+	// Memory effects only show on graphs much larger than the caches.
+	Conflicts::Conflicts<int> random_conflicts(std::mt19937& rng)
+	{
+		size_t edges = 100000;
+		if (const char* value = std::getenv("CONFLICTS_BENCH_EDGES"))
+			edges = std::strtoull(value, nullptr, 10);
+		int objects = static_cast<int>(std::max<size_t>(edges / 4, 16));
+		std::uniform_int_distribution<int> object(0, objects - 1);
+		Conflicts::Conflicts<int> con;
+		con.reserve(objects);
+		while (con.size() < edges)
+		{
+			int a = object(rng), b = object(rng);
+			if (a != b && !con.in_conflict(a, b))
+				con.add(a, b);
+		}
+		return con;
+	}
+}
+
+// Compares the random query throughput of snapshots backed by regular and huge pages.
+TEST(FrozenPages, Throughput)
+{
+	std::mt19937 rng(2024);
+	auto con = random_conflicts(rng);
+	size_t edges = con.size();
+	std::vector<std::pair<uint32_t, uint32_t>> queries(1000000);
+	size_t expected{ 0 };
+	for (auto pages : { Conflicts::Pages::Default, Conflicts::Pages::Transparent, Conflicts::Pages::Explicit })
+	{
+		auto frozen = con.freeze(Conflicts::Ordering::None, pages);
+		std::uniform_int_distribution<uint32_t> id(0, static_cast<uint32_t>(frozen.objects() - 1));
+		if (pages == Conflicts::Pages::Default)
+			for (auto& query : queries)
+				query = { id(rng), id(rng) };
+		size_t hits{ 0 };
+		auto start = std::chrono::steady_clock::now();
+		for (auto& query : queries)
+			hits += frozen.in_conflict(query.first, query.second);
+		std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+		if (pages == Conflicts::Pages::Default)
+			expected = hits;
+		EXPECT_EQ(hits, expected);
+		auto throughput = static_cast<long long>(queries.size() / elapsed.count());
+		const char* name = pages == Conflicts::Pages::Default ? "default" : pages == Conflicts::Pages::Transparent ? "transparent" : "explicit";
+		RecordProperty(std::string(name) + "_queries_per_second", std::to_string(throughput));
+		std::cout << "[ throughput ] " << name << " pages, " << edges << " relationships: " << throughput << " queries/s" << std::endl;
+	}
+}
+
+// Compares the random query throughput of single and batched calls on a snapshot.
+TEST(FrozenBatch, Throughput)
+{
+	std::mt19937 rng(2024);
+	auto frozen = random_conflicts(rng).freeze(Conflicts::Ordering::None);
+	std::uniform_int_distribution<uint32_t> id(0, static_cast<uint32_t>(frozen.objects() - 1));
+	std::vector<std::pair<uint32_t, uint32_t>> queries(1000000);
+	for (auto& query : queries)
+		query = { id(rng), id(rng) };
+	std::unique_ptr<bool[]> results(new bool[queries.size()]);
+
+	auto start = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < queries.size(); ++i)
+		results[i] = frozen.in_conflict_id(queries[i].first, queries[i].second);
+	std::chrono::duration<double> single = std::chrono::steady_clock::now() - start;
+	size_t expected = std::count(results.get(), results.get() + queries.size(), true);
+
+	start = std::chrono::steady_clock::now();
+	frozen.in_conflict(queries.data(), queries.size(), results.get());
+	std::chrono::duration<double> batch = std::chrono::steady_clock::now() - start;
+	EXPECT_EQ(static_cast<size_t>(std::count(results.get(), results.get() + queries.size(), true)), expected);
+
+	auto single_throughput = static_cast<long long>(queries.size() / single.count());
+	auto batch_throughput = static_cast<long long>(queries.size() / batch.count());
+	RecordProperty("single_queries_per_second", std::to_string(single_throughput));
+	RecordProperty("batch_queries_per_second", std::to_string(batch_throughput));
+	std::cout << "[ throughput ] " << frozen.size() << " relationships: " << single_throughput << " single queries/s, "
+		<< batch_throughput << " batched queries/s" << std::endl;
+}
+
+// Compares the intersection kernels with the scalar merge on random sorted lists of various lengths.
+TEST(Simd, Intersect)
+{
+	std::mt19937 rng(7);
+	for (size_t na : { 0, 3, 17, 100, 1000 })
+		for (size_t nb : { 1, 9, 64, 5000 })
+		{
+			std::uniform_int_distribution<uint32_t> value(0, static_cast<uint32_t>(2 * (na + nb)));
+			std::set<uint32_t> set_a, set_b;
+			while (set_a.size() < na)
+				set_a.insert(value(rng));
+			while (set_b.size() < nb)
+				set_b.insert(value(rng));
+			std::vector<uint32_t> a(set_a.begin(), set_a.end()), b(set_b.begin(), set_b.end()), expected;
+			std::set_intersection(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(expected));
+			for (auto level : { Conflicts::Simd::Level::Scalar, Conflicts::Simd::Level::Sse, Conflicts::Simd::Level::Avx2 })
+			{
+				std::vector<uint32_t> out(std::min(na, nb));
+				out.resize(Conflicts::Simd::intersect(a.data(), na, b.data(), nb, out.data(), level));
+				EXPECT_EQ(out, expected) << na << " x " << nb;
+				EXPECT_EQ(Conflicts::Simd::intersects(a.data(), na, b.data(), nb, level), !expected.empty()) << na << " x " << nb;
+			}
+		}
+}
+
+// Compares the similar pairs found by prefix filtering with all the pairs checked one by one.
+TEST(FrozenSimilarity, SimilarPairs)
+{
+	std::mt19937 rng(42);
+	std::uniform_int_distribution<int> object(0, 199);
+	Conflicts::Conflicts<int> con;
+	// a few objects with 4 to 8 conflicts among 20 hubs, so that profiles overlap
+	for (int a = 20; a < 200; ++a)
+	{
+		int count = 4 + a % 5;
+		for (int i = 0; i < count; ++i)
+		{
+			int hub = object(rng) % 20;
+			if (!con.in_conflict(a, hub))
+				con.add(a, hub);
+		}
+	}
+	auto frozen = con.freeze();
+	for (double threshold : { 0.2, 0.5, 2.0 / 3.0, 1.0 })
+	{
+		std::set<std::pair<int, int>> expected, found;
+		for (uint32_t id1 = 0; id1 < frozen.objects(); ++id1)
+			for (uint32_t id2 = id1 + 1; id2 < frozen.objects(); ++id2)
+				if (frozen.similarity_id(id1, id2) >= threshold)
+					expected.insert(std::minmax(frozen.object(id1), frozen.object(id2)));
+		for (auto& pair : frozen.similar_pairs(threshold))
+		{
+			EXPECT_DOUBLE_EQ(pair.similarity, frozen.conflict_similarity(pair.object1, pair.object2));
+			EXPECT_TRUE(found.insert(std::minmax(pair.object1, pair.object2)).second);
+		}
+		EXPECT_EQ(found, expected) << "threshold " << threshold;
+	}
+}
+
+// Compares the resolutions with a greedy selection of the closures of the objects, checked pair by pair,
+// then measures a resolution over 100000 objects.
+TEST(Resolver, Greedy)
+{
+	std::mt19937 rng(7);
+	for (int round = 0; round < 50; ++round)
+	{
+		const int n = 60;
+		Conflicts::Conflicts<int> con{ round % 5 == 4 };
+		Requirements::Requirements<int> req{ false };
+		std::vector<std::vector<int>> requirements(n);
+		for (int i = 0; i < n; ++i)
+		{
+			int count = static_cast<int>(rng() % 3);
+			for (int j = 0; j < count; ++j)
+			{
+				int other = static_cast<int>(rng() % n);
+				if (other != i && std::find(requirements[i].begin(), requirements[i].end(), other) == requirements[i].end())
+				{
+					req.add(i, other);
+					requirements[i].push_back(other);
+				}
+			}
+		}
+		for (int i = 0; i < n / 3; ++i)
+		{
+			int a = static_cast<int>(rng() % n), b = static_cast<int>(rng() % n);
+			if (a != b && !con.in_conflict(a, b))
+				con.add(a, b);
+		}
+		std::vector<int> required, wanted, forbidden;
+		for (int i = 0; i < 3; ++i)
+			required.push_back(static_cast<int>(rng() % n));
+		for (int i = 0; i < 15; ++i)
+			wanted.push_back(static_cast<int>(rng() % n));
+		forbidden.push_back(static_cast<int>(rng() % n));
+
+		// reference
+		std::set<int> selected, refused(forbidden.begin(), forbidden.end());
+		auto closure = [&](int object, std::set<int>& result)
+			{
+				std::vector<int> pending{ object };
+				while (!pending.empty())
+				{
+					int current = pending.back();
+					pending.pop_back();
+					if (refused.count(current) > 0)
+						return false;
+					if (selected.count(current) == 0 && result.insert(current).second)
+						pending.insert(pending.end(), requirements[current].begin(), requirements[current].end());
+				}
+				for (int a : result)
+				{
+					for (int b : result)
+						if (a < b && con.in_conflict(a, b))
+							return false;
+					for (int b : selected)
+						if (con.in_conflict(a, b))
+							return false;
+				}
+				return true;
+			};
+		bool satisfied{ true };
+		for (int object : required)
+		{
+			std::set<int> added;
+			if (!closure(object, added))
+			{
+				satisfied = false;
+				break;
+			}
+			selected.insert(added.begin(), added.end());
+		}
+		std::vector<int> rejected;
+		if (satisfied)
+			for (int object : wanted)
+			{
+				std::set<int> added;
+				if (selected.count(object) > 0)
+					continue;
+				if (closure(object, added))
+					selected.insert(added.begin(), added.end());
+				else
+				{
+					refused.insert(object);
+					rejected.push_back(object);
+				}
+			}
+
+		Conflicts::Resolver<Conflicts::Conflicts<int>> resolver{ con, req };
+		auto resolution = resolver.resolve(required, wanted, forbidden);
+		ASSERT_EQ(resolution.satisfied, satisfied) << "round " << round;
+		EXPECT_EQ(std::set<int>(resolution.selected.begin(), resolution.selected.end()), selected) << "round " << round;
+		EXPECT_EQ(resolution.selected.size(), selected.size()) << "round " << round;
+		if (satisfied)
+			EXPECT_EQ(resolution.rejected, rejected) << "round " << round;
+		else
+			EXPECT_EQ(resolution.conflict.size(), 2) << "round " << round;
+	}
+
+	// chains of requirements over 100000 objects, each object being in conflict with an object of another chain
+	const int n = 100000;
+	Conflicts::Conflicts<int> con;
+	Requirements::Requirements<int> req{ false };
+	std::vector<int> wanted;
+	for (int i = 0; i < n; ++i)
+	{
+		if (i % 10 != 9)
+			req.add(i, i + 1);
+		if (i % 20 == 0 && i + 15 < n)
+			con.add(i, i + 15);
+		if (i % 10 == 0)
+			wanted.push_back(i);
+	}
+	Conflicts::Resolver<Conflicts::Conflicts<int>> resolver{ con, req };
+	auto start = std::chrono::steady_clock::now();
+	auto resolution = resolver.resolve({ 0 }, wanted);
+	std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+	EXPECT_TRUE(resolution.satisfied);
+	EXPECT_EQ(resolution.rejected.size(), n / 20);
+	EXPECT_EQ(resolution.selected.size(), n / 2);
+	RecordProperty("resolution_milliseconds", std::to_string(elapsed.count()));
+	std::cout << "[ throughput ] " << n << " objects resolved in " << elapsed.count() << " ms" << std::endl;
+}
+
+// Applies random changes to the relationships and the requirements, the incremental resolution being compared with a resolution
+// from scratch after each one.
+TEST(Resolver, Incremental)
+{
+	std::mt19937 rng(13);
+	for (int round = 0; round < 30; ++round)
+	{
+		const int n = 40;
+		Conflicts::Conflicts<int> con{ round % 3 == 2 ? Conflicts::Depth{ 2 } : Conflicts::Depth{ round % 3 == 1 ? Conflicts::Depth::unbounded : 1 } };
+		Requirements::Requirements<int> req{ false };
+		std::set<std::pair<int, int>> conflicts, requirements;
+		auto random_pair = [&rng]
+			{
+				int a = static_cast<int>(rng() % n), b = static_cast<int>(rng() % n);
+				return std::make_pair(a, b);
+			};
+		for (int i = 0; i < 40; ++i)
+		{
+			auto [a, b] = random_pair();
+			if (a != b && requirements.insert({ a, b }).second)
+				req.add(a, b);
+		}
+		for (int i = 0; i < 8; ++i)
+		{
+			auto [a, b] = random_pair();
+			if (a != b && !con.in_conflict(a, b) && !(con.cascading() && con.component_id(a) != Conflicts::Conflicts<int>::npos
+				&& con.component_id(a) == con.component_id(b)))
+			{
+				con.add(a, b);
+				conflicts.insert(std::minmax(a, b));
+			}
+		}
+		std::vector<int> required, wanted, forbidden;
+		required.push_back(static_cast<int>(rng() % n));
+		for (int i = 0; i < 20; ++i)
+			wanted.push_back(static_cast<int>(rng() % n));
+		forbidden.push_back(static_cast<int>(rng() % n));
+		Conflicts::IncrementalResolver<Conflicts::Conflicts<int>> incremental{ con, req, required, wanted, forbidden };
+		Conflicts::Resolver<Conflicts::Conflicts<int>> resolver{ con, req };
+		auto previous = resolver.resolve(required, wanted, forbidden);
+		for (int step = 0; step < 60; ++step)
+		{
+			Conflicts::SelectionChanges<int> changes;
+			auto [a, b] = random_pair();
+			if (a == b)
+				continue;
+			switch (rng() % 4)
+			{
+			case 0:
+				// cascading relationships must form a forest
+				if (con.in_conflict(a, b) || (con.cascading() && con.component_id(a) != Conflicts::Conflicts<int>::npos
+					&& con.component_id(a) == con.component_id(b)))
+					continue;
+				con.add(a, b);
+				conflicts.insert(std::minmax(a, b));
+				changes = incremental.conflict_added(a, b);
+				break;
+			case 1:
+			{
+				if (conflicts.empty())
+					continue;
+				auto itr = std::next(conflicts.begin(), rng() % conflicts.size());
+				std::tie(a, b) = *itr;
+				conflicts.erase(itr);
+				con.remove(a, b);
+				changes = incremental.conflict_removed(a, b);
+				break;
+			}
+			case 2:
+				if (!requirements.insert({ a, b }).second)
+					continue;
+				req.add(a, b);
+				changes = incremental.requirement_added(a, b);
+				break;
+			default:
+			{
+				if (requirements.empty())
+					continue;
+				auto itr = std::next(requirements.begin(), rng() % requirements.size());
+				std::tie(a, b) = *itr;
+				requirements.erase(itr);
+				req.remove(a, b);
+				changes = incremental.requirement_removed(a, b);
+				break;
+			}
+			}
+			auto expected = resolver.resolve(required, wanted, forbidden);
+			auto actual = incremental.resolution();
+			ASSERT_EQ(actual.satisfied, expected.satisfied) << "round " << round << ", step " << step;
+			std::set<int> before(previous.selected.begin(), previous.selected.end()), after(expected.selected.begin(), expected.selected.end());
+			EXPECT_EQ(std::set<int>(actual.selected.begin(), actual.selected.end()), after) << "round " << round << ", step " << step;
+			EXPECT_EQ(actual.rejected, expected.rejected) << "round " << round << ", step " << step;
+			EXPECT_EQ(actual.conflict.size(), expected.conflict.size()) << "round " << round << ", step " << step;
+			std::vector<int> selected, unselected;
+			std::set_difference(after.begin(), after.end(), before.begin(), before.end(), std::back_inserter(selected));
+			std::set_difference(before.begin(), before.end(), after.begin(), after.end(), std::back_inserter(unselected));
+			std::sort(changes.selected.begin(), changes.selected.end());
+			std::sort(changes.unselected.begin(), changes.unselected.end());
+			EXPECT_EQ(changes.selected, selected) << "round " << round << ", step " << step;
+			EXPECT_EQ(changes.unselected, unselected) << "round " << round << ", step " << step;
+			for (int object = 0; object < n; ++object)
+				EXPECT_EQ(incremental.selected(object), after.count(object) > 0);
+			previous = std::move(expected);
+		}
+	}
+}
@@ -1,5 +1,17 @@
 #include <gtest/gtest.h>
 #include <conflicts.hpp>
+#include <conflicts_capacity.hpp>
+#include <conflicts_frozen.hpp>
+#include <conflicts_executor.hpp>
+#include <conflicts_locks.hpp>
+#include <conflicts_resolver.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <limits>
+#include <random>
+#include <stdexcept>
 
 enum NiceGuys
 {
@@ -10,6 +22,32 @@ enum NiceGuys
 	Joe
 };
 
+// 128 bits identifier that stores its hash value
+struct WideId
+{
+	uint64_t high;
+	uint64_t low;
+	size_t hash() const noexcept { return m_hash; }
+	bool operator==(const WideId& other) const { return high == other.high && low == other.low; }
+
+	WideId(uint64_t h, uint64_t l) : high(h), low(l), m_hash(static_cast<size_t>((h ^ (l * 0x9E3779B97F4A7C15ull)) * 0xBF58476D1CE4E5B9ull)) {}
+
+private:
+	size_t m_hash;
+};
+
+// clock moved by hand
+struct ManualClock
+{
+	using duration = std::chrono::milliseconds;
+	using rep = duration::rep;
+	using period = duration::period;
+	using time_point = std::chrono::time_point<ManualClock>;
+	static constexpr bool is_steady = true;
+	static time_point now() noexcept { return current; }
+	static inline time_point current{};
+};
+
 class ConflictsTest : public ::testing::Test
 {
 protected:
@@ -95,3 +133,835 @@ TEST_F(ConflictsTest, Clear)
 	EXPECT_EQ(con1.size(), 0);
 	EXPECT_TRUE(con1.empty());
 }
+
+TEST(ConflictsEngines, Conformity)
+{
+	EXPECT_TRUE((Conflicts::is_storage_v<Conflicts::RequirementsStorage<NiceGuys>, NiceGuys>));
+	EXPECT_TRUE((Conflicts::is_storage_v<Conflicts::AdjacencyStorage<NiceGuys>, NiceGuys>));
+	EXPECT_TRUE((Conflicts::is_storage_v<Conflicts::FilteredEngine<>::storage<NiceGuys>, NiceGuys>));
+	EXPECT_FALSE((Conflicts::is_storage_v<std::vector<NiceGuys>, NiceGuys>));
+}
+
+TEST(ConflictsEngines, CustomHash)
+{
+	Conflicts::Conflicts<WideId, Conflicts::DefaultEngine, Conflicts::PrecomputedHash<WideId>> con{ true };
+	con.reserve(3);
+	con.add(WideId(1, 2), WideId(3, 4));
+	con.add(WideId(3, 4), WideId(5, 6));
+	EXPECT_EQ(con.size(), 2);
+	EXPECT_TRUE(con.in_conflict(WideId(1, 2), WideId(5, 6)));
+	EXPECT_EQ(con.get().count(WideId(1, 2)), 1);
+}
+
+TEST(ConflictsValidation, Throwing)
+{
+	Conflicts::Conflicts<NiceGuys, Conflicts::DefaultEngine, std::hash<NiceGuys>, std::equal_to<NiceGuys>, Conflicts::ThrowingValidation> con{ true };
+	con.add(Kyle, Harry);
+	con.add(Harry, Joe);
+	EXPECT_THROW(con.add(Joe, Joe), std::invalid_argument);
+	EXPECT_THROW(con.add(Joe, Harry), std::invalid_argument);
+	EXPECT_THROW(con.add(Kyle, Joe), std::invalid_argument);		// implicit while cascading is on
+	EXPECT_THROW(con.remove(Kyle, Joe), std::invalid_argument);
+	EXPECT_THROW(con.remove(John), std::invalid_argument);
+	EXPECT_EQ(con.size(), 2);
+	con.remove(Harry, Joe);
+	EXPECT_NO_THROW(con.add(Kyle, Joe));
+}
+
+TEST(ConflictsValidation, Trusted)
+{
+	Conflicts::Conflicts<NiceGuys, Conflicts::DefaultEngine, std::hash<NiceGuys>, std::equal_to<NiceGuys>, Conflicts::TrustedValidation> con{ true };
+	con.add(Kyle, Harry);
+	con.add(Harry, Joe);
+	con.add(Jack, Joe);
+	EXPECT_TRUE(con.in_conflict(Kyle, Jack));		// searched without component index
+	con.remove(Harry);
+	EXPECT_FALSE(con.in_conflict(Kyle, Jack));
+	EXPECT_EQ(con.size(), 1);
+}
+
+TEST(ConflictsEngines, Filtered)
+{
+	Conflicts::Conflicts<int, Conflicts::FilteredEngine<>> con;
+	for (int i = 0; i < 1000; i += 2)
+		con.add(i, i + 1);
+	EXPECT_EQ(con.size(), 500);
+	EXPECT_TRUE(con.in_conflict(10, 11));
+	EXPECT_FALSE(con.in_conflict(11, 12));
+	for (int i = 0; i < 1000; i += 4)
+		con.remove(i);
+	EXPECT_EQ(con.size(), 250);
+	EXPECT_FALSE(con.in_conflict(0, 1));
+	EXPECT_FALSE(con.in_conflict(0));
+	EXPECT_TRUE(con.in_conflict(2, 3));
+}
+
+TEST(ConflictsSearch, Hub)
+{
+	// without component index, pairwise checks search the relationships starting from the lowest degrees
+	Conflicts::Conflicts<int, Conflicts::DefaultEngine, std::hash<int>, std::equal_to<int>, Conflicts::TrustedValidation> con{ true };
+	for (int i = 1; i <= 10000; ++i)
+		con.add(0, i);
+	con.add(20000, 20001);
+	con.add(20001, 1);
+	EXPECT_TRUE(con.in_conflict(20000, 5000));
+	EXPECT_TRUE(con.in_conflict(5000, 20000));
+	EXPECT_FALSE(con.in_conflict(20000, 30000));
+	EXPECT_TRUE(con.in_conflict(20000, 20000));
+}
+
+TEST_F(ConflictsTest, Freeze)
+{
+	auto frozen = con2.freeze(Conflicts::Ordering::BreadthFirst);
+	EXPECT_TRUE(frozen.cascading());
+	EXPECT_EQ(frozen.size(), con2.size());
+	EXPECT_TRUE(frozen.in_conflict(Kyle, John));
+	EXPECT_FALSE(frozen.in_conflict(Kyle, static_cast<NiceGuys>(Joe + 1)));
+	EXPECT_EQ(frozen.all_conflicts(John).size(), 4);
+	EXPECT_EQ(frozen.conflicts(Joe).size(), 2);
+	// components are numbered contiguously
+	Conflicts::Conflicts<int> con;
+	con.add(1, 10);
+	con.add(2, 20);
+	con.add(10, 100);
+	con.add(20, 200);
+	auto snapshot = con.freeze(Conflicts::Ordering::ReverseCuthillMcKee);
+	EXPECT_EQ(snapshot.components(), 2);
+	for (uint32_t label = 0; label < snapshot.components(); ++label)
+	{
+		auto members = snapshot.members(label);
+		EXPECT_EQ(members[members.size() - 1] - members[0] + 1, members.size());
+	}
+	// objects of the identifier type are not taken for identifiers
+	Conflicts::Conflicts<uint32_t> wide;
+	wide.add(1000, 2000);
+	auto frozen_wide = wide.freeze();
+	EXPECT_TRUE(frozen_wide.in_conflict(2000u, 1000u));
+	EXPECT_FALSE(frozen_wide.in_conflict(0u, 1u));
+	EXPECT_TRUE(frozen_wide.in_conflict_id(frozen_wide.id(1000), frozen_wide.id(2000)));
+	EXPECT_DOUBLE_EQ(frozen_wide.conflict_similarity(1000u, 1000u), 1.0);
+	EXPECT_EQ(frozen_wide.weight(1000u, 2000u), Conflicts::DefaultWeight);
+}
+
+TEST_F(ConflictsTest, Batch)
+{
+	auto frozen1 = con1.freeze();
+	auto frozen2 = con2.freeze();
+	std::vector<std::pair<NiceGuys, NiceGuys>> queries{ { Kyle, Harry }, { Kyle, Joe }, { Kyle, John }, { John, John } };
+	EXPECT_EQ(frozen1.in_conflict(queries), (std::vector<bool>{ true, false, false, false }));
+	EXPECT_EQ(frozen2.in_conflict(queries), (std::vector<bool>{ true, true, true, true }));
+	auto cons = frozen2.all_conflicts(std::vector<NiceGuys>{ John, Kyle });
+	EXPECT_EQ(cons.size(), 2);
+	EXPECT_EQ(cons[0].size(), 4);
+	EXPECT_EQ(frozen1.all_conflicts(std::vector<NiceGuys>{ John, Kyle })[1].size(), 2);
+}
+
+TEST_F(ConflictsTest, Common_Conflicts)
+{
+	auto cons = con1.common_conflicts(Harry, Jack);		// Kyle and Joe
+	EXPECT_EQ(cons.size(), 2);
+	EXPECT_TRUE(con1.shares_conflict(Harry, Jack));
+	EXPECT_FALSE(con1.shares_conflict(Harry, Kyle));
+	auto frozen = con1.freeze();
+	EXPECT_EQ(frozen.common_conflicts(Harry, Jack).size(), 2);
+	EXPECT_FALSE(frozen.shares_conflict(Harry, John));
+}
+
+TEST_F(ConflictsTest, Compatible_With)
+{
+	std::vector<NiceGuys> everyone{ Kyle, John, Harry, Jack, Joe };
+	EXPECT_EQ(con1.compatible_with({ Kyle, Joe }, everyone), (std::vector<NiceGuys>{ Kyle, John, Joe }));
+	EXPECT_EQ(con1.freeze().compatible_with({ Kyle, Joe }, everyone), (std::vector<NiceGuys>{ Kyle, John, Joe }));
+	EXPECT_TRUE(con2.compatible_with({ John }, everyone).empty());
+	EXPECT_TRUE(con2.freeze().compatible_with({ John }, everyone).empty());
+	EXPECT_EQ(con0.compatible_with({ John }, everyone), everyone);
+}
+
+TEST_F(ConflictsTest, Similarity)
+{
+	EXPECT_DOUBLE_EQ(con1.conflict_similarity(Harry, Jack), 1.0);	// both in conflict with Kyle and Joe
+	EXPECT_DOUBLE_EQ(con1.conflict_similarity(Kyle, Harry), 0.0);
+	EXPECT_DOUBLE_EQ(con1.conflict_similarity(Kyle, John), 0.0);
+	auto frozen = con1.freeze();
+	EXPECT_DOUBLE_EQ(frozen.conflict_similarity(Kyle, Joe), 1.0);
+	EXPECT_EQ(frozen.similar_pairs(1.0).size(), 2);
+	EXPECT_EQ(frozen.similar_pairs(0.5).size(), 2);
+}
+
+TEST(ConflictsRanking, Top)
+{
+	Conflicts::Conflicts<int, Conflicts::RankedEngine<>> con{ true };
+	for (int i = 1; i <= 5; ++i)
+		con.add(0, i);
+	con.add(10, 11);
+	con.add(10, 12);
+	con.add(20, 21);
+	EXPECT_EQ(con.top_conflicted(2), (std::vector<std::pair<int, size_t>>{ { 0, 5 }, { 10, 2 } }));
+	EXPECT_EQ(con.largest_components(5), (std::vector<size_t>{ 6, 3, 2 }));
+	con.remove(0);
+	con.remove(10, 11);
+	EXPECT_EQ(con.top_conflicted(1)[0].second, 1);
+	EXPECT_EQ(con.top_conflicted(10).size(), 4);
+	EXPECT_EQ(con.largest_components(5), (std::vector<size_t>{ 2, 2 }));
+	Conflicts::Conflicts<int> plain;
+	plain.add(1, 2);
+	plain.add(1, 3);
+	EXPECT_EQ(plain.top_conflicted(1), (std::vector<std::pair<int, size_t>>{ { 1, 2 } }));
+	EXPECT_EQ(plain.largest_components(1), (std::vector<size_t>{ 3 }));
+}
+
+TEST_F(ConflictsTest, Components)
+{
+	auto list = con2.components();
+	EXPECT_EQ(list.size(), 1);
+	EXPECT_EQ(list.members.size(), 5);
+	EXPECT_EQ(con2.component_id(Kyle), con2.component_id(John));
+	EXPECT_EQ(con1.components().size(), 1);
+	// without cascading, the components are labelled by a union-find pass
+	Conflicts::Conflicts<WideId, Conflicts::DefaultEngine, Conflicts::PrecomputedHash<WideId>> con;
+	con.add({ 0, 1 }, { 0, 2 });
+	con.add({ 0, 3 }, { 0, 4 });
+	con.add({ 0, 2 }, { 0, 5 });
+	auto wide = con.components();
+	ASSERT_EQ(wide.size(), 2);
+	std::vector<size_t> sizes{ wide.offsets[1] - wide.offsets[0], wide.offsets[2] - wide.offsets[1] };
+	std::sort(sizes.begin(), sizes.end());
+	EXPECT_EQ(sizes, (std::vector<size_t>{ 2, 3 }));
+	EXPECT_EQ(con.component_id({ 0, 1 }), con.component_id({ 0, 5 }));
+	EXPECT_NE(con.component_id({ 0, 1 }), con.component_id({ 0, 3 }));
+	EXPECT_EQ(con.component_id({ 0, 9 }), con.npos);
+	auto labels = con.component_labels();
+	EXPECT_EQ(labels.size(), 5);
+	EXPECT_EQ(labels.at({ 0, 1 }), con.component_id({ 0, 1 }));
+	EXPECT_EQ(labels.at({ 0, 4 }), con.component_id({ 0, 4 }));
+	EXPECT_EQ(con2.component_labels().at(Kyle), con2.component_id(Kyle));
+}
+
+TEST(ConflictsDepth, Bounded)
+{
+	// a chain 0 - 1 - 2 - 3 - 4 with a depth of 2
+	Conflicts::Conflicts<int> con{ Conflicts::Depth{ 2 } };
+	EXPECT_FALSE(con.cascading());
+	EXPECT_EQ(con.depth(), 2);
+	for (int i = 0; i < 4; ++i)
+		con.add(i, i + 1);
+	EXPECT_TRUE(con.in_conflict(0, 2));
+	EXPECT_FALSE(con.in_conflict(0, 3));
+	EXPECT_FALSE(con.in_conflict(0, 0));
+	EXPECT_EQ(con.all_conflicts(2).size(), 4);
+	EXPECT_EQ(con.conflicts_within(0, 3), (std::vector<int>{ 1, 2, 3 }));
+	auto frozen = con.freeze();
+	EXPECT_EQ(frozen.depth(), 2);
+	EXPECT_TRUE(frozen.in_conflict(4, 2));
+	EXPECT_FALSE(frozen.in_conflict(4, 1));
+	EXPECT_EQ(frozen.conflicts_within(4, 10).size(), 4);
+	EXPECT_TRUE(Conflicts::Conflicts<int>{ Conflicts::Depth{ Conflicts::Depth::unbounded } }.cascading());
+}
+
+TEST(ConflictsWeight, Threshold)
+{
+	Conflicts::Conflicts<int> con{ true };
+	con.add(1, 2, 5);
+	con.add(2, 3, 1);
+	con.add(3, 4, 5);
+	con.add(2, 5);
+	EXPECT_EQ(con.weight(2, 1), 5);
+	EXPECT_EQ(con.weight(2, 5), Conflicts::DefaultWeight);
+	EXPECT_EQ(con.conflicts(2, 2).size(), 1);
+	EXPECT_TRUE(con.in_conflict(1, 4));
+	EXPECT_FALSE(con.in_conflict(1, 4, 2));
+	EXPECT_TRUE(con.in_conflict(4, 3, 2));
+	auto frozen = con.freeze();
+	EXPECT_EQ(frozen.weight(3, 4), 5);
+	EXPECT_EQ(frozen.conflicts(2, 2), (std::vector<int>{ 1 }));
+	EXPECT_EQ(frozen.conflicts(2, 0).size(), 3);
+	EXPECT_EQ(frozen.conflicts(2, 0).front(), 1);	// heaviest first
+	EXPECT_FALSE(frozen.in_conflict(1, 4, 2));
+	EXPECT_TRUE(frozen.in_conflict(1, 4, 1));
+	EXPECT_THROW(frozen.weight(1, 9), std::out_of_range);
+	EXPECT_THROW(frozen.weight(1, 3), std::out_of_range);
+	Conflicts::Conflicts<int> direct;
+	direct.add(1, 2, 5);
+	direct.add(2, 3, 1);
+	direct.add(2, 4);
+	auto frozen_direct = direct.freeze();
+	EXPECT_TRUE(frozen_direct.in_conflict(2, 1, 5));
+	EXPECT_FALSE(frozen_direct.in_conflict(3, 2, 2));
+	EXPECT_FALSE(frozen_direct.in_conflict(1, 3, 0));
+	// storages without weights have the default weight
+	Conflicts::Conflicts<int, Conflicts::RequirementsEngine> plain;
+	plain.add(1, 2);
+	EXPECT_EQ(plain.conflicts(1, 2).size(), 0);
+	EXPECT_TRUE(plain.in_conflict(1, 2, 1));
+}
+
+TEST(ConflictsExpiry, Wheel)
+{
+	// deadlines spread over many levels, released in order
+	Conflicts::TimerWheel<int> wheel;
+	std::mt19937_64 rng{ 5 };
+	std::vector<uint64_t> deadlines;
+	for (int i = 0; i < 2000; ++i)
+	{
+		uint64_t deadline = rng() >> (rng() % 64);
+		deadlines.push_back(deadline);
+		wheel.schedule(deadline, i);
+	}
+	std::sort(deadlines.begin(), deadlines.end());
+	std::vector<uint64_t> released;
+	for (uint64_t tick : { uint64_t{ 1000 }, uint64_t{ 1 } << 40, std::numeric_limits<uint64_t>::max() })
+	{
+		wheel.advance(tick, [&](uint64_t deadline, int) { EXPECT_LE(deadline, tick); released.push_back(deadline); });
+		EXPECT_EQ(wheel.size(), static_cast<size_t>(deadlines.end() - std::upper_bound(deadlines.begin(), deadlines.end(), tick)));
+	}
+	EXPECT_EQ(released, deadlines);
+	EXPECT_TRUE(wheel.empty());
+}
+
+TEST(ConflictsExpiry, TimeToLive)
+{
+	using namespace std::chrono_literals;
+	EXPECT_TRUE((Conflicts::is_expiring_v<Conflicts::ExpiringEngine<>::storage<int>, int>));
+	EXPECT_FALSE((Conflicts::is_expiring_v<Conflicts::DefaultEngine::storage<int>, int>));
+	ManualClock::current = {};
+	Conflicts::Conflicts<int, Conflicts::ExpiringEngine<Conflicts::RankedEngine<>, ManualClock>> con{ true };
+	con.add(1, 2, 10ms);
+	con.add(2, 3);
+	con.add(3, 4, 20ms);
+	con.add(5, 6, 0ms);
+	EXPECT_EQ(con.size(), 3);
+	EXPECT_TRUE(con.in_conflict(1, 4));
+	ManualClock::current += 10ms;
+	EXPECT_FALSE(con.in_conflict(1, 2));
+	EXPECT_FALSE(con.in_conflict(1));
+	EXPECT_EQ(con.size(), 2);
+	EXPECT_EQ(con.top_conflicted(1).front().second, 2);
+	// a relationship created again outlives its former timer
+	con.remove(3, 4);
+	con.add(3, 4);
+	ManualClock::current += 1h;
+	EXPECT_EQ(con.size(), 2);
+	EXPECT_TRUE(con.in_conflict(4, 2));
+	con.add(1, 4, 1s);
+	EXPECT_TRUE(con.in_conflict(1, 2));
+	ManualClock::current += 1s;
+	EXPECT_EQ(con.all_conflicts(1).size(), 0);
+	EXPECT_EQ(con.freeze().size(), 2);
+	// queries skip the expired relationships without removing them, the ranking being corrected
+	con.add(6, 7, 5ms);
+	con.add(6, 8, 5ms);
+	con.add(6, 9, 5ms);
+	EXPECT_EQ(con.top_conflicted(1).front(), std::make_pair(6, size_t{ 3 }));
+	ManualClock::current += 5ms;
+	EXPECT_FALSE(con.in_conflict(6));
+	EXPECT_EQ(con.top_conflicted(1).front().second, 2);
+	EXPECT_EQ(con.top_conflicted(9).size(), 3);
+	con.expire();
+	EXPECT_EQ(con.size(), 2);
+	Conflicts::ExpiringEngine<Conflicts::RankedEngine<>, ManualClock>::storage<int> storage;
+	storage.add(1, 2, 5ms);
+	storage.add(2, 3);
+	ManualClock::current += 5ms;
+	EXPECT_EQ(storage.at(ManualClock::current - 1ms).size(), 2);
+	EXPECT_EQ(storage.at(ManualClock::current).degree(2), 1);
+	storage.expire();
+	EXPECT_EQ(storage.at(ManualClock::current - 1ms).size(), 1);
+}
+
+TEST(ConflictsGroups, Rules)
+{
+	EXPECT_TRUE((Conflicts::is_grouped_v<Conflicts::GroupedEngine<>::storage<int>, int>));
+	EXPECT_TRUE((Conflicts::is_implicit_v<Conflicts::GroupedEngine<>::storage<int>, int>));
+	EXPECT_FALSE((Conflicts::is_implicit_v<Conflicts::FilteredEngine<>::storage<int>, int>));
+	Conflicts::Conflicts<int, Conflicts::GroupedEngine<>> con;
+	for (int i = 0; i < 3; ++i)
+		con.join(i, "left");
+	for (int i = 3; i < 6; ++i)
+		con.join(i, "right");
+	con.add(6, 7);
+	EXPECT_FALSE(con.in_conflict(0, 3));
+	con.add_group_conflict("left", "right");
+	EXPECT_EQ(con.size(), 10);
+	EXPECT_TRUE(con.in_conflict(2, 4));
+	EXPECT_FALSE(con.in_conflict(1, 2));
+	EXPECT_EQ(con.conflicts(5).size(), 3);
+	con.join(6, "right");
+	EXPECT_TRUE(con.in_conflict(6, 0));
+	EXPECT_EQ(con.conflicts(6).size(), 4);
+	// a member of both groups is in conflict with the other members, not with itself
+	con.join(0, "right");
+	EXPECT_EQ(con.conflicts(0).size(), 6);
+	EXPECT_EQ(con.size(), 15);
+	con.leave(0, "right");
+	con.remove_group_conflict("right", "left");
+	EXPECT_FALSE(con.in_conflict(0));
+	EXPECT_EQ(con.size(), 1);
+	con.add_group_conflict("left", "left");
+	EXPECT_TRUE(con.in_conflict(0, 1));
+	EXPECT_EQ(con.get().size(), 4);
+	con.remove(1);
+	EXPECT_EQ(con.conflicts(0), (std::vector<int>{ 2 }));
+	// rules set cycles, that cascading searches visit once
+	Conflicts::Conflicts<int, Conflicts::GroupedEngine<>> cascading{ true };
+	for (int i = 0; i < 6; ++i)
+		cascading.join(i, i < 3 ? "left" : "right");
+	cascading.add_group_conflict("left", "right");
+	cascading.add(5, 6);
+	EXPECT_TRUE(cascading.in_conflict(1, 2));
+	EXPECT_TRUE(cascading.in_conflict(0, 6));
+	EXPECT_FALSE(cascading.in_conflict(0, 7));
+	EXPECT_EQ(cascading.all_conflicts(6).size(), 6);
+}
+
+TEST(ConflictsGroups, Expansion)
+{
+	// random memberships, rules and relationships, compared with the same conflicts set pair by pair
+	std::mt19937 rng{ 11 };
+	Conflicts::Conflicts<int, Conflicts::GroupedEngine<Conflicts::AdjacencyEngine, int>> con;
+	std::vector<std::vector<bool>> member(30, std::vector<bool>(6)), rule(6, std::vector<bool>(6)), expected(30, std::vector<bool>(30));
+	for (int i = 0; i < 40; ++i)
+	{
+		int object = static_cast<int>(rng() % 30), group = static_cast<int>(rng() % 6);
+		if (!member[object][group])
+			con.join(object, group);
+		member[object][group] = true;
+	}
+	for (int i = 0; i < 4; ++i)
+	{
+		int group1 = static_cast<int>(rng() % 6), group2 = static_cast<int>(rng() % 6);
+		if (!rule[group1][group2])
+			con.add_group_conflict(group1, group2);
+		rule[group1][group2] = rule[group2][group1] = true;
+	}
+	for (int a = 0; a < 30; ++a)
+		for (int b = 0; b < 30; ++b)
+			for (int group1 = 0; group1 < 6; ++group1)
+				for (int group2 = 0; group2 < 6; ++group2)
+					if (a != b && member[a][group1] && member[b][group2] && rule[group1][group2])
+						expected[a][b] = true;
+	for (int i = 0; i < 10; ++i)
+	{
+		int a = static_cast<int>(rng() % 30), b = static_cast<int>(rng() % 30);
+		if (a != b && !expected[a][b])
+		{
+			con.add(a, b);
+			expected[a][b] = expected[b][a] = true;
+		}
+	}
+	size_t size{ 0 };
+	for (int a = 0; a < 30; ++a)
+	{
+		std::vector<int> conflicts;
+		for (int b = 0; b < 30; ++b)
+		{
+			if (expected[a][b])
+				conflicts.push_back(b);
+			EXPECT_EQ(con.in_conflict(a, b), expected[a][b]) << "objects " << a << ", " << b;
+		}
+		size += conflicts.size();
+		auto actual = con.conflicts(a);
+		std::sort(actual.begin(), actual.end());
+		EXPECT_EQ(actual, conflicts) << "object " << a;
+		EXPECT_EQ(con.in_conflict(a), !conflicts.empty()) << "object " << a;
+	}
+	EXPECT_EQ(con.size(), size / 2);
+	EXPECT_EQ(con.get().size(), size / 2);
+	// the number of relationships is kept up to date by the changes of the memberships and the rules
+	for (int i = 0; i < 200; ++i)
+	{
+		int object = static_cast<int>(rng() % 30), group1 = static_cast<int>(rng() % 6), group2 = static_cast<int>(rng() % 6);
+		switch (rng() % 4)
+		{
+		case 0:
+			if (member[object][group1])
+				con.leave(object, group1);
+			else
+				con.join(object, group1);
+			member[object][group1] = !member[object][group1];
+			break;
+		case 1:
+			if (rule[group1][group2])
+				con.remove_group_conflict(group1, group2);
+			else
+				con.add_group_conflict(group1, group2);
+			rule[group1][group2] = rule[group2][group1] = !rule[group1][group2];
+			break;
+		case 2:
+			if (con.in_conflict(object))
+			{
+				con.remove(object);
+				member[object].assign(6, false);
+			}
+			break;
+		default:
+			if (object != group1 && !con.in_conflict(object, group1))
+				con.add(object, group1);
+		}
+		ASSERT_EQ(con.size(), con.get().size()) << "step " << i;
+	}
+}
+
+TEST(ConflictsIntervals, Overlap)
+{
+	EXPECT_TRUE((Conflicts::is_interval_v<Conflicts::IntervalEngine<>::storage<int>, int>));
+	Conflicts::Conflicts<int, Conflicts::IntervalEngine<Conflicts::AdjacencyEngine, int>> con;
+	con.set_interval(1, 0, 10);
+	con.set_interval(2, 10, 20);
+	con.set_interval(3, 5, 15);
+	con.add(2, 4);
+	EXPECT_FALSE(con.in_conflict(1, 2));	// half-open intervals
+	EXPECT_TRUE(con.in_conflict(3, 2));
+	EXPECT_EQ(con.size(), 3);
+	EXPECT_EQ(con.conflicts(2).size(), 2);
+	con.set_interval(3, 20, 30);
+	EXPECT_FALSE(con.in_conflict(3));
+	EXPECT_EQ(con.size(), 1);
+	con.set_interval(4, 25, 26);
+	EXPECT_EQ(con.size(), 2);
+	con.remove_interval(3);
+	con.remove(2);
+	EXPECT_TRUE(con.empty());
+}
+
+TEST(ConflictsIntervals, Expansion)
+{
+	// random intervals, moved and removed, compared with a scan of all the pairs
+	std::mt19937 rng{ 3 };
+	Conflicts::Conflicts<int, Conflicts::IntervalEngine<Conflicts::AdjacencyEngine, int>> con;
+	std::vector<std::pair<int, int>> intervals(60, { 0, 0 });
+	for (int step = 0; step < 300; ++step)
+	{
+		int object = static_cast<int>(rng() % 60);
+		if (rng() % 4 == 0)
+		{
+			if (intervals[object].first < intervals[object].second)
+				con.remove_interval(object);
+			intervals[object] = { 0, 0 };
+		}
+		else
+		{
+			int start = static_cast<int>(rng() % 1000);
+			intervals[object] = { start, start + 1 + static_cast<int>(rng() % 40) };
+			con.set_interval(object, intervals[object].first, intervals[object].second);
+		}
+	}
+	size_t size{ 0 };
+	for (int a = 0; a < 60; ++a)
+	{
+		std::vector<int> expected;
+		for (int b = 0; b < 60; ++b)
+			if (a != b && intervals[a].first < intervals[b].second && intervals[b].first < intervals[a].second)
+				expected.push_back(b);
+		size += expected.size();
+		auto actual = con.conflicts(a);
+		std::sort(actual.begin(), actual.end());
+		EXPECT_EQ(actual, expected) << "object " << a;
+		for (int b = 0; b < 60; ++b)
+			EXPECT_EQ(con.in_conflict(a, b), std::binary_search(expected.begin(), expected.end(), b)) << "objects " << a << ", " << b;
+	}
+	EXPECT_EQ(con.size(), size / 2);
+	EXPECT_EQ(con.get().size(), size / 2);
+}
+
+TEST(ConflictsCapacity, AtMost)
+{
+	// at most 2 of the jobs 0 to 9, and at most 1 of the jobs 8 to 11
+	Conflicts::CapacityConstraints<int> capacities;
+	std::vector<int> jobs(10);
+	for (int i = 0; i < 10; ++i)
+		jobs[i] = i;
+	auto pair = capacities.add(jobs, 2);
+	auto single = capacities.add({ 8, 9, 10, 11, 11 }, 1);
+	EXPECT_EQ(capacities.size(), 2);
+	EXPECT_EQ(capacities.members(single).size(), 4);
+	EXPECT_EQ(capacities.constraints(9).size(), 2);
+	EXPECT_TRUE(capacities.try_acquire(0));
+	EXPECT_TRUE(capacities.try_acquire(10));
+	EXPECT_FALSE(capacities.admissible(8));
+	EXPECT_TRUE(capacities.try_acquire(1));
+	EXPECT_EQ(capacities.count(pair), 2);
+	EXPECT_FALSE(capacities.try_acquire(2));
+	EXPECT_TRUE(capacities.admissible(20));
+	capacities.release(0);
+	EXPECT_TRUE(capacities.admissible(2));
+	EXPECT_FALSE(capacities.admissible(9));
+	capacities.remove(single);
+	EXPECT_TRUE(capacities.try_acquire(9));
+	EXPECT_EQ(capacities.add({ 11 }, 0), single);	// identifiers are given again
+	EXPECT_FALSE(capacities.admissible(11));
+	capacities.reset();
+	EXPECT_EQ(capacities.count(pair), 0);
+}
+
+TEST(ConflictsExecutor, Direct)
+{
+	// a ring of 16 objects, each one in conflict with its neighbours
+	Conflicts::Conflicts<int> con;
+	for (int i = 0; i < 16; ++i)
+		con.add(i, (i + 1) % 16);
+	std::vector<std::atomic<int>> running(16);
+	std::atomic<int> runs{ 0 }, overlaps{ 0 };
+	{
+		Conflicts::ConflictExecutor<Conflicts::Conflicts<int>> executor{ con, 4 };
+		for (int j = 0; j < 200; ++j)
+		{
+			int object = j * 7 % 16;
+			executor.submit(object, [&, object]
+				{
+					if (running[object]++ > 0 || running[(object + 1) % 16] > 0 || running[(object + 15) % 16] > 0)
+						++overlaps;
+					std::this_thread::yield();
+					--running[object];
+					++runs;
+				});
+		}
+		executor.wait();
+		EXPECT_EQ(executor.waiting(), 0);
+		EXPECT_EQ(executor.running(), 0);
+	}
+	EXPECT_EQ(runs, 200);
+	EXPECT_EQ(overlaps, 0);
+}
+
+TEST(ConflictsExecutor, Cascading)
+{
+	// two chains, a job at a time per chain, the unrelated objects running freely
+	Conflicts::Conflicts<int> con{ true };
+	for (int i = 0; i < 4; ++i)
+	{
+		con.add(i, i + 1);
+		con.add(i + 10, i + 11);
+	}
+	std::atomic<int> chains[2]{}, runs{ 0 }, overlaps{ 0 };
+	Conflicts::ConflictExecutor<Conflicts::Conflicts<int>> executor{ con, 4 };
+	for (int round = 0; round < 2; ++round)
+	{
+		for (int j = 0; j < 100; ++j)
+		{
+			int object = j % 25;
+			executor.submit(object, [&, object]
+				{
+					std::atomic<int>* chain = object <= 4 ? &chains[0] : object >= 10 && object <= 14 ? &chains[1] : nullptr;
+					if (chain != nullptr && (*chain)++ > 0)
+						++overlaps;
+					std::this_thread::yield();
+					if (chain != nullptr)
+						--*chain;
+					++runs;
+				});
+		}
+		executor.wait();
+	}
+	EXPECT_EQ(runs, 200);
+	EXPECT_EQ(overlaps, 0);
+	// the relationships changed while the executor is idle are seen from the next submission
+	con.add(4, 10);
+	std::atomic<int> joined{ 0 };
+	for (int j = 0; j < 100; ++j)
+	{
+		int object = j % 15;
+		executor.submit(object, [&, object]
+			{
+				bool member = object <= 4 || object >= 10;
+				if (member && joined++ > 0)
+					++overlaps;
+				std::this_thread::yield();
+				if (member)
+					--joined;
+			});
+	}
+	executor.wait();
+	EXPECT_EQ(overlaps, 0);
+}
+
+TEST(ConflictsExecutor, Capacity)
+{
+	// no conflict, at most 2 of the objects 0 to 7 running together
+	Conflicts::Conflicts<int> con;
+	Conflicts::ConflictExecutor<Conflicts::Conflicts<int>>::capacities_type capacities;
+	capacities.add({ 0, 1, 2, 3, 4, 5, 6, 7 }, 2);
+	std::atomic<int> running{ 0 }, peak{ 0 }, runs{ 0 };
+	Conflicts::ConflictExecutor<Conflicts::Conflicts<int>> executor{ con, 4, &capacities };
+	for (int j = 0; j < 100; ++j)
+		executor.submit(j % 8, [&]
+			{
+				int now = ++running;
+				int previous = peak;
+				while (now > previous && !peak.compare_exchange_weak(previous, now));
+				std::this_thread::yield();
+				--running;
+				++runs;
+			});
+	executor.wait();
+	EXPECT_EQ(runs, 100);
+	EXPECT_LE(peak, 2);
+	EXPECT_EQ(capacities.count(0), 0);
+	// a job that can't be admitted
+	capacities.add({ 9 }, 0);
+	executor.submit(9, [] {});
+	EXPECT_THROW(executor.wait(), std::runtime_error);
+	// once the constraint is removed, the next job of the object is dispatched after the waiting one
+	capacities.clear();
+	executor.submit(9, [&] { ++runs; });
+	EXPECT_NO_THROW(executor.wait());
+	EXPECT_EQ(runs, 101);
+}
+
+TEST(ConflictsExecutor, Exception)
+{
+	Conflicts::Conflicts<int> con;
+	con.add(1, 2);
+	std::atomic<int> runs{ 0 };
+	Conflicts::ConflictExecutor<Conflicts::Conflicts<int>> executor{ con, 2 };
+	executor.submit(1, [] { throw std::logic_error("failure"); });
+	for (int j = 0; j < 10; ++j)
+		executor.submit(j % 3, [&] { ++runs; });
+	EXPECT_THROW(executor.wait(), std::logic_error);
+	EXPECT_EQ(runs, 10);
+	EXPECT_NO_THROW(executor.wait());
+}
+
+TEST(ConflictsLocks, Exclusion)
+{
+	Conflicts::Conflicts<int> con;
+	con.add(1, 2);
+	con.add(2, 3);
+	Conflicts::ConflictLockManager<Conflicts::Conflicts<int>> locks{ con, 4 };
+	locks.acquire(1);
+	EXPECT_TRUE(locks.held(1));
+	EXPECT_FALSE(locks.try_acquire(1));
+	EXPECT_FALSE(locks.try_acquire(2));
+	EXPECT_TRUE(locks.try_acquire(3));
+	EXPECT_TRUE(locks.try_acquire(4));
+	EXPECT_FALSE(locks.try_acquire_for(2, std::chrono::milliseconds(5)));
+	locks.release(1);
+	EXPECT_FALSE(locks.try_acquire(2));
+	locks.release(3);
+	EXPECT_TRUE(locks.try_acquire_for(2, std::chrono::milliseconds(5)));
+	EXPECT_FALSE(locks.held(1));
+	locks.release(2);
+	locks.release(4);
+	// a waiting owner is woken up by the release of an object in conflict
+	locks.acquire(3);
+	std::thread waiter([&locks] { locks.acquire(2); locks.release(2); });
+	std::this_thread::sleep_for(std::chrono::milliseconds(5));
+	EXPECT_FALSE(locks.try_acquire(2));
+	locks.release(3);
+	waiter.join();
+	EXPECT_FALSE(locks.held(2));
+}
+
+TEST(ConflictsLocks, Concurrency)
+{
+	// a ring of 32 objects, each one in conflict with its neighbours, locked by 4 threads
+	Conflicts::Conflicts<int> con;
+	for (int i = 0; i < 32; ++i)
+		con.add(i, (i + 1) % 32);
+	Conflicts::ConflictLockManager<Conflicts::Conflicts<int>> locks{ con, 8 };
+	std::vector<std::atomic<int>> holders(32);
+	std::atomic<int> overlaps{ 0 }, timeouts{ 0 };
+	std::vector<std::thread> threads;
+	for (int t = 0; t < 4; ++t)
+		threads.emplace_back([&, t]
+			{
+				std::mt19937 rng(t);
+				for (int i = 0; i < 2000; ++i)
+				{
+					int object = static_cast<int>(rng() % 32);
+					if (i % 4 == 0)
+					{
+						if (!locks.try_acquire_for(object, std::chrono::microseconds(50)))
+						{
+							++timeouts;
+							continue;
+						}
+					}
+					else
+						locks.acquire(object);
+					if (holders[object]++ > 0 || holders[(object + 1) % 32] > 0 || holders[(object + 31) % 32] > 0)
+						++overlaps;
+					std::this_thread::yield();
+					--holders[object];
+					locks.release(object);
+				}
+			});
+	for (auto& thread : threads)
+		thread.join();
+	EXPECT_EQ(overlaps, 0);
+	for (int i = 0; i < 32; ++i)
+		EXPECT_FALSE(locks.held(i));
+}
+
+TEST(ConflictsResolver, Selection)
+{
+	// 1 requires 2 and 3, 4 requires 5, 3 is in conflict with 5
+	Conflicts::Conflicts<int> con;
+	con.add(3, 5);
+	con.add(6, 7);
+	Requirements::Requirements<int> req{ false };
+	req.add(1, 2);
+	req.add(1, 3);
+	req.add(4, 5);
+	Conflicts::Resolver<Conflicts::Conflicts<int>> resolver{ con, req };
+	auto resolution = resolver.resolve({ 1 }, { 4, 6, 7, 2 });
+	EXPECT_TRUE(resolution.satisfied);
+	std::sort(resolution.selected.begin(), resolution.selected.end());
+	EXPECT_EQ(resolution.selected, (std::vector<int>{ 1, 2, 3, 6 }));
+	EXPECT_EQ(resolution.rejected, (std::vector<int>{ 4, 7 }));
+	resolution = resolver.resolve({ 1, 4 });
+	EXPECT_FALSE(resolution.satisfied);
+	EXPECT_EQ(resolution.conflict, (std::vector<int>{ 5, 3 }));
+	EXPECT_EQ(resolution.selected.size(), 3);
+	// a forbidden requirement
+	resolution = resolver.resolve({ 4 }, {}, { 5 });
+	EXPECT_FALSE(resolution.satisfied);
+	EXPECT_EQ(resolution.conflict, (std::vector<int>{ 4, 5 }));
+	EXPECT_TRUE(resolution.selected.empty());
+	// in cascading mode, a single member of each component is selected
+	Conflicts::Conflicts<int> cascading{ true };
+	cascading.add(3, 8);
+	cascading.add(8, 5);
+	Conflicts::Resolver<Conflicts::Conflicts<int>> components{ cascading, req };
+	resolution = components.resolve({ 4 }, { 1, 8 });
+	EXPECT_TRUE(resolution.satisfied);
+	EXPECT_EQ(resolution.rejected, (std::vector<int>{ 1, 8 }));
+}
+
+TEST(ConflictsResolver, Incremental)
+{
+	// 1 requires 2, 3 requires 4, 5 and 6 are wanted
+	Conflicts::Conflicts<int> con;
+	Requirements::Requirements<int> req{ false };
+	req.add(1, 2);
+	req.add(3, 4);
+	Conflicts::IncrementalResolver<Conflicts::Conflicts<int>> resolver{ con, req, { 1 }, { 3, 5, 6 } };
+	EXPECT_TRUE(resolver.resolution().satisfied);
+	EXPECT_EQ(resolver.resolution().selected.size(), 6);
+	// 4 is in conflict with 2: the decision selecting 3 is refused
+	con.add(4, 2);
+	auto changes = resolver.conflict_added(4, 2);
+	std::sort(changes.unselected.begin(), changes.unselected.end());
+	EXPECT_EQ(changes.unselected, (std::vector<int>{ 3, 4 }));
+	EXPECT_TRUE(changes.selected.empty());
+	EXPECT_EQ(resolver.resolution().rejected, (std::vector<int>{ 3 }));
+	// unrelated changes keep the selection
+	con.add(7, 8);
+	EXPECT_TRUE(resolver.conflict_added(7, 8).empty());
+	req.add(7, 9);
+	EXPECT_TRUE(resolver.requirement_added(7, 9).empty());
+	// 5 now requires 3, in conflict with the required objects
+	req.add(5, 3);
+	changes = resolver.requirement_added(5, 3);
+	EXPECT_EQ(changes.unselected, (std::vector<int>{ 5 }));
+	EXPECT_FALSE(resolver.selected(5));
+	// the conflict removed, 3 and 5 are selected again
+	con.remove(4, 2);
+	changes = resolver.conflict_removed(4, 2);
+	std::sort(changes.selected.begin(), changes.selected.end());
+	EXPECT_EQ(changes.selected, (std::vector<int>{ 3, 4, 5 }));
+	EXPECT_TRUE(resolver.resolution().rejected.empty());
+	req.remove(3, 4);
+	changes = resolver.requirement_removed(3, 4);
+	EXPECT_EQ(changes.unselected, (std::vector<int>{ 4 }));
+	EXPECT_TRUE(changes.selected.empty());
+}